@@ -0,0 +1,249 @@
+#include "Aggregate.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define AGGREGATE_SSE2
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define TARGET_AVX __attribute__((target("avx")))
+#else
+#define TARGET_AVX
+#endif
+
+void accumulateScalar(const double*, const CellType*, std::size_t, std::size_t, Aggregate::Totals&);
+void accumulateSse2(const double*, const CellType*, std::size_t, Aggregate::Totals&);
+void accumulateAvx(const double*, const CellType*, std::size_t, Aggregate::Totals&);
+bool detectAvx();
+
+/**
+ * @brief	Number of bits set in every 4 bit mask
+ */
+
+const int BIT_COUNTS[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+/**
+ * @brief	Fastest kernel the processor supports
+ *
+ * @returns	AVX, SSE2 or scalar kernel
+ */
+
+Aggregate::Kernel Aggregate::bestKernel() {
+	static const Kernel best = isSupported(Kernel::Avx) ? Kernel::Avx : isSupported(Kernel::Sse2) ? Kernel::Sse2 : Kernel::Scalar;
+	return best;
+}
+
+/**
+ * @brief				Checks if a kernel was built in and the processor supports it
+ *
+ * @param [in]	kernel	Kernel to check
+ *
+ * @returns				True if the kernel can be used
+ */
+
+bool Aggregate::isSupported(Kernel kernel) {
+#ifdef AGGREGATE_SSE2
+	static const bool avx = detectAvx();
+	return kernel != Kernel::Avx || avx;
+#else
+	return kernel == Kernel::Scalar;
+#endif
+}
+
+/**
+ * @brief				Accumulates a run of cells, each a given number of cells
+ * 						after the previous one. Contiguous runs are accumulated
+ * 						with the best kernel available
+ *
+ * @param [in]	values	Value of the first cell
+ *
+ * @param [in]	types	Type tag of the first cell
+ *
+ * @param [in]	count	Number of cells
+ *
+ * @param [in]	stride	Distance between consecutive cells, in cells
+ *
+ * @param [in,out] totals	Totals to accumulate the number and formula cells into
+ *
+ */
+
+void Aggregate::accumulate(const double* values, const CellType* types, std::size_t count, std::size_t stride, Totals& totals) {
+	if (stride == 1)
+		accumulate(values, types, count, totals, bestKernel());
+	else
+		accumulateScalar(values, types, count, stride, totals);
+}
+
+/**
+ * @brief				Accumulates a contiguous run of cells with given kernel,
+ * 						which should be supported
+ *
+ * @param [in]	values	Values of the cells
+ *
+ * @param [in]	types	Type tags of the cells
+ *
+ * @param [in]	count	Number of cells
+ *
+ * @param [in,out] totals	Totals to accumulate the number and formula cells into
+ *
+ * @param [in]	kernel	Kernel to use
+ *
+ */
+
+void Aggregate::accumulate(const double* values, const CellType* types, std::size_t count, Totals& totals, Kernel kernel) {
+#ifdef AGGREGATE_SSE2
+	if (kernel == Kernel::Avx)
+		return accumulateAvx(values, types, count, totals);
+
+	if (kernel == Kernel::Sse2)
+		return accumulateSse2(values, types, count, totals);
+#endif
+
+	accumulateScalar(values, types, count, 1, totals);
+}
+
+/**
+ * @brief	Plain loop over the cells, for strided runs and processors without SSE2
+ *
+ */
+
+void accumulateScalar(const double* values, const CellType* types, std::size_t count, std::size_t stride, Aggregate::Totals& totals) {
+	for (std::size_t i = 0; i < count * stride; i += stride) {
+		bool numeric = types[i] == CellType::Number || types[i] == CellType::Formula;
+		double value = values[i];
+
+		totals.sum += numeric ? value : 0.;
+		totals.minimum = numeric && value < totals.minimum ? value : totals.minimum;
+		totals.maximum = numeric && value > totals.maximum ? value : totals.maximum;
+		totals.count += numeric;
+	}
+}
+
+#ifdef AGGREGATE_SSE2
+
+/**
+ * @brief	Two cells per step. The type tags are compared bytewise and the
+ * 			resulting byte masks are widened to the 64 bit lanes of the values
+ *
+ */
+
+void accumulateSse2(const double* values, const CellType* types, std::size_t count, Aggregate::Totals& totals) {
+	const __m128i number = _mm_set1_epi8((char)CellType::Number), formula = _mm_set1_epi8((char)CellType::Formula);
+	const __m128d infinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+	const __m128d negativeInfinity = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+	__m128d sum = _mm_setzero_pd(), minimum = infinity, maximum = negativeInfinity;
+	std::size_t numeric = 0, i = 0;
+
+	for (; i + 2 <= count; i += 2) {
+		std::uint16_t tags;
+		std::memcpy(&tags, types + i, sizeof(tags));
+
+		__m128i tag = _mm_cvtsi32_si128(tags);
+		__m128i mask8 = _mm_or_si128(_mm_cmpeq_epi8(tag, number), _mm_cmpeq_epi8(tag, formula));
+		__m128i mask16 = _mm_unpacklo_epi8(mask8, mask8);
+		__m128i mask32 = _mm_unpacklo_epi16(mask16, mask16);
+		__m128d mask = _mm_castsi128_pd(_mm_unpacklo_epi32(mask32, mask32));
+		__m128d value = _mm_loadu_pd(values + i);
+		__m128d taken = _mm_and_pd(mask, value);
+
+		numeric += BIT_COUNTS[_mm_movemask_epi8(mask8) & 3];
+		sum = _mm_add_pd(sum, taken);
+		minimum = _mm_min_pd(_mm_or_pd(taken, _mm_andnot_pd(mask, infinity)), minimum);
+		maximum = _mm_max_pd(_mm_or_pd(taken, _mm_andnot_pd(mask, negativeInfinity)), maximum);
+	}
+
+	double lanes[2];
+
+	_mm_storeu_pd(lanes, sum);
+	totals.sum += lanes[0] + lanes[1];
+	_mm_storeu_pd(lanes, minimum);
+	totals.minimum = std::min({ totals.minimum, lanes[0], lanes[1] });
+	_mm_storeu_pd(lanes, maximum);
+	totals.maximum = std::max({ totals.maximum, lanes[0], lanes[1] });
+	totals.count += numeric;
+
+	accumulateScalar(values + i, types + i, count - i, 1, totals);
+}
+
+/**
+ * @brief	Eight cells per step in two sets of four lane registers, to keep
+ * 			two additions in flight. The type tag masks are computed for all
+ * 			eight cells at once and sign extended to the 64 bit lanes
+ *
+ */
+
+TARGET_AVX void accumulateAvx(const double* values, const CellType* types, std::size_t count, Aggregate::Totals& totals) {
+	const __m128i number = _mm_set1_epi8((char)CellType::Number), formula = _mm_set1_epi8((char)CellType::Formula);
+	const __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+	const __m256d negativeInfinity = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+	__m256d sum[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+	__m256d minimum[2] = { infinity, infinity }, maximum[2] = { negativeInfinity, negativeInfinity };
+	std::size_t numeric = 0, i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i tag = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(types + i));
+		__m128i mask8 = _mm_or_si128(_mm_cmpeq_epi8(tag, number), _mm_cmpeq_epi8(tag, formula));
+		int bits = _mm_movemask_epi8(mask8);
+
+		__m128i quarters[4] = { _mm_cvtepi8_epi64(mask8), _mm_cvtepi8_epi64(_mm_srli_si128(mask8, 2)),
+			_mm_cvtepi8_epi64(_mm_srli_si128(mask8, 4)), _mm_cvtepi8_epi64(_mm_srli_si128(mask8, 6)) };
+
+		numeric += BIT_COUNTS[bits & 15] + BIT_COUNTS[(bits >> 4) & 15];
+
+		for (int k = 0; k < 2; ++k) {
+			__m256d mask = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_castsi128_pd(quarters[2 * k])), _mm_castsi128_pd(quarters[2 * k + 1]), 1);
+			__m256d value = _mm256_loadu_pd(values + i + 4 * k);
+
+			__m256d taken = _mm256_and_pd(mask, value);
+
+			sum[k] = _mm256_add_pd(sum[k], taken);
+			minimum[k] = _mm256_min_pd(_mm256_or_pd(taken, _mm256_andnot_pd(mask, infinity)), minimum[k]);
+			maximum[k] = _mm256_max_pd(_mm256_or_pd(taken, _mm256_andnot_pd(mask, negativeInfinity)), maximum[k]);
+		}
+	}
+
+	double lanes[3][4];
+
+	_mm256_storeu_pd(lanes[0], _mm256_add_pd(sum[0], sum[1]));
+	_mm256_storeu_pd(lanes[1], _mm256_min_pd(minimum[0], minimum[1]));
+	_mm256_storeu_pd(lanes[2], _mm256_max_pd(maximum[0], maximum[1]));
+
+	for (int k = 0; k < 4; ++k) {
+		totals.sum += lanes[0][k];
+		totals.minimum = std::min(totals.minimum, lanes[1][k]);
+		totals.maximum = std::max(totals.maximum, lanes[2][k]);
+	}
+
+	totals.count += numeric;
+
+	accumulateScalar(values + i, types + i, count - i, 1, totals);
+}
+
+/**
+ * @brief	Checks that the processor supports AVX and the OS saves its registers
+ *
+ * @returns	True if AVX instructions can be used
+ */
+
+bool detectAvx() {
+#if defined(__GNUC__)
+	return __builtin_cpu_supports("avx");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	bool osSaves = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+	return osSaves && avx && (_xgetbv(0) & 6) == 6;
+#else
+	return false;
+#endif
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "CellStore.h"
+#include <cstddef>
+#include <limits>
+
+/**
+ * @namespace	Aggregate
+ *
+ * @brief		Kernels accumulating the number and formula cells of a run of
+ * 				cells, as read by the SUM, AVG, MIN, MAX and COUNT functions of
+ * 				formulas. Contiguous runs are processed with SSE2 or AVX where
+ * 				the processor supports them, other cells are skipped by masking
+ * 				on their type tags rather than by branching
+ */
+
+namespace Aggregate
+{
+	/**
+	 * @struct	Totals
+	 *
+	 * @brief	Running totals of the number and formula cells accumulated so far
+	 */
+
+	struct Totals
+	{
+		double sum = 0.;
+		double minimum = std::numeric_limits<double>::infinity();
+		double maximum = -std::numeric_limits<double>::infinity();
+		std::size_t count = 0;
+	};
+
+	/**
+	 * @enum	Kernel
+	 *
+	 * @brief	Instruction set a contiguous run is accumulated with
+	 */
+
+	enum class Kernel
+	{
+		Scalar,
+		Sse2,
+		Avx
+	};
+
+	Kernel bestKernel();
+	bool isSupported(Kernel);
+	void accumulate(const double*, const CellType*, std::size_t, std::size_t, Totals&);
+	void accumulate(const double*, const CellType*, std::size_t, Totals&, Kernel);
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include "BackgroundSaver.h"
+#include "Snapshot.h"
+#include "Console.h"
+#include <cstdio>
+#include <fstream>
+#include <streambuf>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @class	ProgressBuffer
+ *
+ * @brief	Stream buffer passing what is written on to another one, counting
+ * 			the bytes as progress. Once the progress is cancelled every write
+ * 			fails, so the stream writing stops with its fail bit set
+ *
+ */
+
+class ProgressBuffer : public std::streambuf
+{
+public:
+	ProgressBuffer(std::streambuf* target, Progress& progress) :target(target), progress(progress) {
+	}
+
+protected:
+	std::streamsize xsputn(const char* data, std::streamsize count) override {
+		if (progress.isCancelled())
+			return 0;
+
+		std::streamsize written = target->sputn(data, count);
+		progress.advance(written);
+		return written;
+	}
+
+	int_type overflow(int_type c) override {
+		if (traits_type::eq_int_type(c, traits_type::eof()))
+			return traits_type::not_eof(c);
+
+		if (progress.isCancelled())
+			return traits_type::eof();
+
+		progress.advance(1);
+		return target->sputc(traits_type::to_char_type(c));
+	}
+
+	int sync() override {
+		return target->pubsync();
+	}
+
+private:
+	/**
+	 * @brief	Buffer written to
+	 */
+
+	std::streambuf* target;
+
+	/**
+	 * @brief	Progress counting the bytes written
+	 */
+
+	Progress& progress;
+};
+
+/**
+ * @brief	Constructs a saver and starts its worker thread
+ *
+ */
+
+BackgroundSaver::BackgroundSaver() :requester(nullptr), failed(0), reportingWritten(true), reportsHeld(false), busy(false), stopping(false) {
+	worker = std::thread(&BackgroundSaver::run, this);
+}
+
+/**
+ * @brief	Destructor finishing the pending saves and joining the worker
+ *
+ */
+
+BackgroundSaver::~BackgroundSaver() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+
+	wake.notify_one();
+	worker.join();
+}
+
+/**
+ * @brief				Requests a table version to be saved in the background. Saves
+ * 						are written in the order requested. A save of the same file
+ * 						still waiting is replaced by this one, keeping its place. The
+ * 						save is reported to the console of the calling thread
+ *
+ * @param [in]	table	Version of the table to save, held by the saver until written
+ *
+ * @param [in]	file	Target file, saved as a snapshot if .etb and as text otherwise
+ *
+ * @param [in]	done	Function called on the saver thread once the file is written,
+ * 						with false if writing failed. Not called if the save is replaced
+ *
+ */
+
+void BackgroundSaver::save(std::shared_ptr<const Table> table, const std::string& file, std::function<void(bool)> done) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto [it, added] = pending.insert_or_assign(file, Job{ std::move(table), std::move(done), &Console::out() });
+
+		if (added)
+			order.push_back(file);
+	}
+
+	wake.notify_one();
+}
+
+/**
+ * @brief	Blocks until every requested save is done
+ *
+ */
+
+void BackgroundSaver::wait() {
+	std::unique_lock<std::mutex> guard(lock);
+	idle.wait(guard, [this] { return pending.empty() && !busy; });
+}
+
+/**
+ * @brief				Blocks until the saves requested for a file are done, so
+ * 						the file can be read with the contents last saved to it
+ *
+ * @param [in]	file	Target file
+ *
+ */
+
+void BackgroundSaver::wait(const std::string& file) {
+	std::unique_lock<std::mutex> guard(lock);
+	idle.wait(guard, [this, &file] { return pending.count(file) == 0 && target != file; });
+}
+
+/**
+ * @brief	Cancels every save: the saves waiting are dropped without calling
+ * 			their functions, the one being written is stopped and reported
+ * 			as failed, leaving its target as it was
+ *
+ * @returns	True if there was a save to cancel
+ */
+
+bool BackgroundSaver::cancel() {
+	std::string message;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		for (const std::string& file : order)
+			message += "Saving the file " + file + " cancelled!\n";
+
+		pending.clear();
+		order.clear();
+
+		bool stopped = writing != nullptr && writing->cancel();
+
+		if (!busy)
+			idle.notify_all();
+
+		if (message.empty() && !stopped)
+			return false;
+	}
+
+	Console::out() << message << std::flush;
+	return true;
+}
+
+/**
+ * @brief	Gives the progress of the save being written
+ *
+ * @returns	Progress in bytes written, null if no save is being written
+ */
+
+std::shared_ptr<Progress> BackgroundSaver::current() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return writing;
+}
+
+/**
+ * @brief				Sets if saves written are reported, or only those failed
+ *
+ * @param [in]	written	False to report failed saves only
+ *
+ */
+
+void BackgroundSaver::reportWritten(bool written) {
+	std::lock_guard<std::mutex> guard(lock);
+	reportingWritten = written;
+}
+
+/**
+ * @brief	Checks if some reports are held, for any console, without taking
+ * 			the lock
+ *
+ * @returns	True if there may be reports to take
+ */
+
+bool BackgroundSaver::hasReports() const {
+	return reportsHeld.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief	Takes the reports held for the console output of the calling thread
+ *
+ * @returns	Reports of the saves it requested done since last taken, one per line
+ */
+
+std::string BackgroundSaver::takeReports() {
+	std::lock_guard<std::mutex> guard(lock);
+	auto held = reports.find(&Console::out());
+
+	if (held == reports.end())
+		return "";
+
+	std::string taken = std::move(held->second);
+	reports.erase(held);
+	reportsHeld = !reports.empty();
+	return taken;
+}
+
+/**
+ * @brief				Drops the reports held for a console output about to be
+ * 						destroyed, and those of its saves still to be done
+ *
+ * @param [in]	output	Console output of a client leaving
+ *
+ */
+
+void BackgroundSaver::forget(std::ostream& output) {
+	std::lock_guard<std::mutex> guard(lock);
+	reports.erase(&output);
+	reportsHeld = !reports.empty();
+
+	for (auto& [file, job] : pending)
+		if (job.requester == &output)
+			job.requester = nullptr;
+
+	if (requester == &output)
+		requester = nullptr;
+}
+
+/**
+ * @brief	Gives the number of saves that failed to be written
+ *
+ * @returns	Number of failed saves, cancelled ones not counted
+ */
+
+std::size_t BackgroundSaver::failures() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return failed;
+}
+
+/**
+ * @brief	Main loop of the worker: takes the pending saves one at a time
+ * 			and writes them, until stopped with nothing left to save
+ *
+ */
+
+void BackgroundSaver::run() {
+	std::unique_lock<std::mutex> guard(lock);
+
+	while (true) {
+		wake.wait(guard, [this] { return stopping || !pending.empty(); });
+
+		if (pending.empty())
+			return;
+
+		std::string file = std::move(order.front());
+		order.pop_front();
+		Job job = std::move(pending.at(file));
+		pending.erase(file);
+		busy = true;
+		target = file;
+		requester = job.requester;
+		std::shared_ptr<Progress> progress = writing = std::make_shared<Progress>("save " + file);
+		guard.unlock();
+
+		bool written = write(*job.table, file, *progress);
+		job.table.reset();
+
+		if (job.done)
+			job.done(written);
+
+		std::string message = written ? "Table saved successfully as " + file + "!\n" : "Error saving the file " + file + "!\n";
+
+		if (!written && progress->isCancelled())
+			message = "Saving the file " + file + " cancelled!\n";
+
+		guard.lock();
+
+		if (requester != nullptr && (!written || reportingWritten)) {
+			reports[requester] += message;
+			reportsHeld = true;
+		}
+
+		if (!written && !progress->isCancelled())
+			++failed;
+
+		writing = nullptr;
+		target.clear();
+		requester = nullptr;
+		busy = false;
+		idle.notify_all();
+	}
+}
+
+/**
+ * @brief				Writes a table to a file atomically: the table is written to
+ * 						a temporary file next to the target, which is flushed to disk
+ * 						and renamed over the target. The directory is flushed as well,
+ * 						so the rename survives a crash
+ *
+ * @param [in]	table	Table to write
+ *
+ * @param [in]	file	Target file, written as a snapshot if .etb and as text otherwise
+ *
+ * @param [in]	progress	Progress in bytes written. Once cancelled, writing stops
+ * 							and the temporary file is removed
+ *
+ * @returns				True if the target holds the table, false otherwise
+ */
+
+bool BackgroundSaver::write(const Table& table, const std::string& file, Progress& progress) {
+	std::string temporary = file + ".tmp";
+	std::ofstream output(temporary, std::ios::out | std::ios::trunc | std::ios::binary);
+
+	if (!output.is_open())
+		return false;
+
+	ProgressBuffer counted(output.rdbuf(), progress);
+	std::ostream stream(&counted);
+
+	if (Snapshot::isSnapshotFile(file))
+		Snapshot::save(table, stream);
+	else
+		stream << table;
+
+	output.close();
+
+	if (!stream || !output || !syncPath(temporary) || !progress.commit()) {
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	std::remove(file.c_str());
+#endif
+
+	if (std::rename(temporary.c_str(), file.c_str()) != 0) {
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+	std::size_t separator = file.find_last_of('/');
+	syncPath(separator == std::string::npos ? "." : file.substr(0, separator + 1));
+	return true;
+}
+
+/**
+ * @brief				Flushes a file or directory to disk
+ *
+ * @param [in]	path	File or directory to flush
+ *
+ * @returns				True if flushed, false otherwise
+ */
+
+bool BackgroundSaver::syncPath(const std::string& path) {
+#ifdef _WIN32
+	return true;
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+
+	if (descriptor < 0)
+		return false;
+
+	bool synced = fsync(descriptor) == 0;
+	::close(descriptor);
+	return synced;
+#endif
+}
@@ -0,0 +1,166 @@
+#ifndef BACKGROUND_SAVER_H
+#define BACKGROUND_SAVER_H
+
+#include "Table.h"
+#include "Progress.h"
+#include <atomic>
+#include <ostream>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @class	BackgroundSaver
+ *
+ * @brief	Saves versions of tables on a background thread. Every save writes
+ * 			a temporary file next to the target, flushes it to disk and renames
+ * 			it over the target, so the target always holds either the old or
+ * 			the new contents. Saves requested for a target while an earlier one
+ * 			is still waiting are coalesced, only the latest version is written.
+ * 			Completion and failures are held for the console that requested
+ * 			the save, which writes them out before its next command, so they
+ * 			reach the client that asked and never cut into other output. Cancelling
+ * 			drops the saves waiting and stops the one being written before it
+ * 			is renamed, so the target keeps its old contents
+ *
+ */
+
+class BackgroundSaver
+{
+public:
+	BackgroundSaver();
+	~BackgroundSaver();
+
+	BackgroundSaver(const BackgroundSaver&) = delete;
+	BackgroundSaver& operator=(const BackgroundSaver&) = delete;
+
+	void save(std::shared_ptr<const Table>, const std::string&, std::function<void(bool)> = nullptr);
+	void wait();
+	void wait(const std::string&);
+	bool cancel();
+	std::shared_ptr<Progress> current() const;
+	void reportWritten(bool);
+	bool hasReports() const;
+	std::string takeReports();
+	void forget(std::ostream&);
+	std::size_t failures() const;
+
+	static bool write(const Table&, const std::string&, Progress&);
+	static bool syncPath(const std::string&);
+
+private:
+	/**
+	 * @struct	Job
+	 *
+	 * @brief	Table version waiting to be saved, with the function called once it is
+	 * 			and the console output of the command requesting it
+	 */
+
+	struct Job
+	{
+		std::shared_ptr<const Table> table;
+		std::function<void(bool)> done;
+		std::ostream* requester;
+	};
+
+	/**
+	 * @brief	Saves waiting to be written, keyed by target file
+	 */
+
+	std::unordered_map<std::string, Job> pending;
+
+	/**
+	 * @brief	Target files of the saves waiting, in the order first requested
+	 */
+
+	std::deque<std::string> order;
+
+	/**
+	 * @brief	Target file of the save being written, empty if none
+	 */
+
+	std::string target;
+
+	/**
+	 * @brief	Console output the save being written is reported to, null if
+	 * 			none or forgotten
+	 */
+
+	std::ostream* requester;
+
+	/**
+	 * @brief	Progress of the save being written, null if none
+	 */
+
+	std::shared_ptr<Progress> writing;
+
+	/**
+	 * @brief	Guards the pending saves, the progress and the flags below
+	 */
+
+	mutable std::mutex lock;
+
+	/**
+	 * @brief	Signalled when a save is requested or the saver stops
+	 */
+
+	std::condition_variable wake;
+
+	/**
+	 * @brief	Signalled when a save is done
+	 */
+
+	std::condition_variable idle;
+
+	/**
+	 * @brief	Number of saves that failed, not counting those cancelled
+	 */
+
+	std::size_t failed;
+
+	/**
+	 * @brief	True to report saves written as well as failed ones
+	 */
+
+	bool reportingWritten;
+
+	/**
+	 * @brief	Reports held, not taken yet, keyed by the console output of the
+	 * 			commands requesting the saves
+	 */
+
+	std::unordered_map<std::ostream*, std::string> reports;
+
+	/**
+	 * @brief	True while some reports are held, read without the lock
+	 */
+
+	std::atomic<bool> reportsHeld;
+
+	/**
+	 * @brief	True while a save is being written
+	 */
+
+	bool busy;
+
+	/**
+	 * @brief	Set to make the worker exit
+	 */
+
+	bool stopping;
+
+	/**
+	 * @brief	Thread writing the saves
+	 */
+
+	std::thread worker;
+
+	void run();
+};
+
+#endif
@@ -1,21 +0,0 @@
-#include "Cell.h"
-#include <iostream>
-
-//definition must be provided if the pure virtual function is the destructor
-
-/**
- * @fn	Cell::~Cell()
- *
- * @brief	Destructor for abstract class (Definition is not neccesary for a pure
- * 			virtual function unless it is the destructor)
- *
- */
-
-Cell::~Cell() {
-}
-
-
-
-
-
-
@@ -0,0 +1,154 @@
+#include "CellSet.h"
+
+/**
+ * @brief				Constructs an empty set of the cells of a table
+ *
+ * @param [in]	rows	Number of rows of the table
+ *
+ * @param [in]	columns	Number of columns of the table
+ *
+ */
+
+CellSet::CellSet(int rows, int columns) :rows(rows), columns(columns), count(0) {
+}
+
+/**
+ * @brief				Empties the set and sets the dimensions of the table
+ *
+ * @param [in]	rows	New number of rows
+ *
+ * @param [in]	columns	New number of columns
+ *
+ */
+
+void CellSet::reset(int rows, int columns) {
+	clear();
+	this->rows = rows;
+	this->columns = columns;
+}
+
+/**
+ * @brief	Empties the set, releasing the bitmap
+ *
+ */
+
+void CellSet::clear() {
+	count = 0;
+	std::vector<std::uint64_t>().swap(words);
+}
+
+/**
+ * @brief				Adds a cell to the set
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				True if the cell was added, false if it was in the set already
+ */
+
+bool CellSet::insert(std::size_t index) {
+	if (words.empty())
+		words.assign(((std::size_t)rows * columns + 63) / 64, 0);
+
+	std::size_t bit = bitOf(index);
+	std::uint64_t mask = (std::uint64_t)1 << (bit % 64);
+
+	if (words[bit / 64] & mask)
+		return false;
+
+	words[bit / 64] |= mask;
+	++count;
+	return true;
+}
+
+/**
+ * @brief				Removes a cell from the set, if present
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ */
+
+void CellSet::erase(std::size_t index) {
+	if (!contains(index))
+		return;
+
+	std::size_t bit = bitOf(index);
+	words[bit / 64] &= ~((std::uint64_t)1 << (bit % 64));
+	--count;
+}
+
+/**
+ * @brief				Checks if a cell is in the set
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				True if the cell is in the set
+ */
+
+bool CellSet::contains(std::size_t index) const {
+	if (count == 0)
+		return false;
+
+	std::size_t bit = bitOf(index);
+	return (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+/**
+ * @brief					Finds the first row of a run of rows of a column whose
+ * 							cell is in the set, skipping words with no cell in it
+ *
+ * @param [in]	col			Zero-based column
+ *
+ * @param [in]	firstRow	Zero-based first row of the run
+ *
+ * @param [in]	lastRow		Zero-based last row of the run
+ *
+ * @returns					Row of the first cell found, lastRow + 1 if there is none
+ */
+
+int CellSet::next(int col, int firstRow, int lastRow) const {
+	if (count == 0 || firstRow > lastRow)
+		return lastRow + 1;
+
+	std::size_t base = (std::size_t)col * rows;
+	std::size_t bit = base + firstRow, end = base + lastRow + 1;
+
+	while (bit < end) {
+		std::uint64_t word = words[bit / 64] >> (bit % 64);
+
+		if (word == 0) {
+			bit = (bit / 64 + 1) * 64;
+			continue;
+		}
+
+		while ((word & 1) == 0) {
+			word >>= 1;
+			++bit;
+		}
+
+		return bit < end ? (int)(bit - base) : lastRow + 1;
+	}
+
+	return lastRow + 1;
+}
+
+/**
+ * @brief	Gives the number of cells in the set
+ *
+ * @returns	Number of cells
+ */
+
+std::size_t CellSet::size() const {
+	return count;
+}
+
+/**
+ * @brief				Gives the bit of a cell in the bitmap
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				Position of the bit
+ */
+
+std::size_t CellSet::bitOf(std::size_t index) const {
+	return (index % columns) * rows + index / columns;
+}
@@ -0,0 +1,59 @@
+#ifndef CELL_SET_H
+#define CELL_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class	CellSet
+ *
+ * @brief	Set of the cells of a table kept as a bitmap, one bit per cell.
+ * 			Bits run down the columns, so the cells of a column within a
+ * 			run of rows are found a word of 64 rows at a time. The bitmap
+ * 			is allocated when the first cell is inserted
+ *
+ */
+
+class CellSet
+{
+public:
+	CellSet(int, int);
+
+	void reset(int, int);
+	void clear();
+	bool insert(std::size_t);
+	void erase(std::size_t);
+	bool contains(std::size_t) const;
+	int next(int, int, int) const;
+	std::size_t size() const;
+
+private:
+	/**
+	 * @brief	Number of rows of the table
+	 */
+
+	int rows;
+
+	/**
+	 * @brief	Number of columns of the table
+	 */
+
+	int columns;
+
+	/**
+	 * @brief	Number of cells in the set
+	 */
+
+	std::size_t count;
+
+	/**
+	 * @brief	Bitmap of the cells, the bit of a cell at column * rows + row
+	 */
+
+	std::vector<std::uint64_t> words;
+
+	std::size_t bitOf(std::size_t) const;
+};
+
+#endif
@@ -0,0 +1,855 @@
+#include "CellStore.h"
+#include "StringUtils.h"
+#include "Aggregate.h"
+#include "ColumnIndex.h"
+#include <algorithm>
+#include <string>
+
+void accumulateBlock(const double*, const CellType*, int, int, std::size_t, Aggregate::Totals&);
+
+/**
+ * Narrowest block rows still accumulated row by row with the vector kernels,
+ * narrower blocks are accumulated column by column
+ */
+
+const int MIN_VECTOR_RUN = 8;
+
+/**
+ * Shortest narrow range whose columns are given an aggregate index,
+ * shorter ones are scanned
+ */
+
+const int MIN_INDEXED_ROWS = 256;
+
+/**
+ * @brief	Constructs a tile with all its cells empty
+ *
+ */
+
+CellStore::Tile::Tile() : used(0) {
+	for (int i = 0; i < TILE_SIZE * TILE_SIZE; ++i) {
+		types[i] = CellType::Empty;
+		values[i] = 0.;
+	}
+}
+
+/**
+ * @brief				   Constructs a store of empty cells for a table
+ * 						   of given number of rows and columns
+ *
+ * @param [in]	rows	   Number of rows
+ *
+ * @param [in]	columns	   Number of columns
+ *
+ * @param [in]	mode	   Storage layout, dense by default
+ *
+ */
+
+CellStore::CellStore(int rows, int columns, StorageMode mode) : rows(rows), columns(columns), mode(mode) {
+	if (mode == StorageMode::Dense) {
+		types.assign((std::size_t)rows * columns, CellType::Empty);
+		values.assign((std::size_t)rows * columns, 0.);
+	}
+
+	else
+		tiles.resize((rows + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+/**
+ * @brief				Copies a store, sharing its pages, tiles, texts and aggregate
+ * 						indices with it until either changes them
+ *
+ * @param [in]	other	Store to copy
+ *
+ */
+
+CellStore::CellStore(const CellStore& other) : rows(other.rows), columns(other.columns), mode(other.mode), types(other.types),
+	values(other.values), textIds(other.textIds), snapshot(other.snapshot), tiles(other.tiles), texts(other.texts),
+	indices(other.indices) {
+}
+
+CellStore::CellStore(CellStore&&) = default;
+CellStore::~CellStore() = default;
+CellStore& CellStore::operator=(CellStore&&) = default;
+
+/**
+ * @brief				Gives the text of a text cell, without
+ * 						the enclosing quotation marks
+ *
+ * @param [in]	index	Absolute index of a text cell
+ *
+ * @returns				Text of the cell, kept in the text pool
+ */
+
+const std::string& CellStore::text(std::size_t index) const {
+	return texts->text(textId(index));
+}
+
+/**
+ * @brief				Gives the string representation of a cell. Numbers and formula
+ * 						results are formatted with up to 3 digits after the floating point,
+ * 						texts are returned quoted, error cells as 'ERROR' and
+ * 						empty cells as an empty string
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				String representation of the cell
+ */
+
+std::string CellStore::toString(std::size_t index) const {
+	switch (type(index)) {
+	case CellType::Number:
+	case CellType::Formula:
+		return StringUtils::formatNumber(value(index));
+	case CellType::Text:
+		return '"' + text(index) + '"';
+	case CellType::Error:
+		return "ERROR";
+	default:
+		return "";
+	}
+}
+
+/**
+ * @brief				Gives the first column at or after the given one, in the given
+ * 						row, that may hold a non-empty cell. In sparse mode whole
+ * 						missing tiles are skipped, in dense mode the column is
+ * 						returned unchanged
+ *
+ * @param [in]	row		Zero-based row
+ *
+ * @param [in]	col		Zero-based column to start from
+ *
+ * @returns				Zero-based column, or the number of columns if the
+ * 						rest of the row is empty
+ */
+
+int CellStore::skipEmpty(int row, int col) const {
+	if (mode == StorageMode::Dense)
+		return col;
+
+	const std::map<int, std::shared_ptr<Tile>>& tileRow = tiles[row / TILE_SIZE];
+	auto it = tileRow.lower_bound(col / TILE_SIZE);
+
+	if (it == tileRow.end())
+		return columns;
+
+	if (it->first == col / TILE_SIZE)
+		return col;
+
+	return it->first * TILE_SIZE;
+}
+
+/**
+ * @brief					Accumulates the number and formula cells of a range. The whole
+ * 							blocks of rows in columns of narrow ranges with an aggregate index
+ * 							are read from it in O(log n), other cells are scanned
+ *
+ * @param [in]	firstRow	Zero-based first row of the range
+ *
+ * @param [in]	firstCol	Zero-based first column of the range
+ *
+ * @param [in]	lastRow		Zero-based last row of the range
+ *
+ * @param [in]	lastCol		Zero-based last column of the range
+ *
+ * @param [in,out] totals	Totals to accumulate the cells into
+ *
+ */
+
+void CellStore::aggregate(int firstRow, int firstCol, int lastRow, int lastCol, Aggregate::Totals& totals) const {
+	if (firstRow > lastRow || firstCol > lastCol)
+		return;
+
+	if (!indices.empty() && isIndexed(firstRow, firstCol, lastRow, lastCol)) {
+		for (int col = firstCol; col <= lastCol; ++col) {
+			auto index = indices.find(col);
+			int firstBlock = (firstRow + ColumnIndex::BLOCK_ROWS - 1) / ColumnIndex::BLOCK_ROWS;
+			int lastBlock = (lastRow + 1) / ColumnIndex::BLOCK_ROWS - 1;
+
+			if (index == indices.end() || firstBlock > lastBlock) {
+				scan(firstRow, col, lastRow, col, totals);
+				continue;
+			}
+
+			scan(firstRow, col, firstBlock * ColumnIndex::BLOCK_ROWS - 1, col, totals);
+			index->second->query(firstBlock, lastBlock, totals);
+			scan((lastBlock + 1) * ColumnIndex::BLOCK_ROWS, col, lastRow, col, totals);
+		}
+
+		return;
+	}
+
+	scan(firstRow, firstCol, lastRow, lastCol, totals);
+}
+
+/**
+ * @brief					Gives the columns of a range an aggregate index, kept up to
+ * 							date with every change of their cells until released, if the
+ * 							range is narrow and tall enough to gain from one. Indices are
+ * 							shared by all ranges over their column and built on first use
+ *
+ * @param [in]	firstRow	Zero-based first row of the range
+ *
+ * @param [in]	firstCol	Zero-based first column of the range
+ *
+ * @param [in]	lastRow		Zero-based last row of the range
+ *
+ * @param [in]	lastCol		Zero-based last column of the range
+ *
+ */
+
+void CellStore::retainIndices(int firstRow, int firstCol, int lastRow, int lastCol) {
+	if (!isIndexed(firstRow, firstCol, lastRow, lastCol))
+		return;
+
+	for (int col = firstCol; col <= lastCol; ++col) {
+		auto index = indices.find(col);
+
+		if (index == indices.end()) {
+			index = indices.emplace(col, CopyOnWrite<ColumnIndex>(ColumnIndex(rows))).first;
+			buildIndex(col, index->second.write());
+		}
+
+		++index->second.write().users;
+	}
+}
+
+/**
+ * @brief					Releases the aggregate indices retained for a range. The
+ * 							index of a column is freed once no range uses it anymore
+ *
+ * @param [in]	firstRow	Zero-based first row of the range
+ *
+ * @param [in]	firstCol	Zero-based first column of the range
+ *
+ * @param [in]	lastRow		Zero-based last row of the range
+ *
+ * @param [in]	lastCol		Zero-based last column of the range
+ *
+ */
+
+void CellStore::releaseIndices(int firstRow, int firstCol, int lastRow, int lastCol) {
+	if (!isIndexed(firstRow, firstCol, lastRow, lastCol))
+		return;
+
+	for (int col = firstCol; col <= lastCol; ++col) {
+		auto index = indices.find(col);
+
+		if (index == indices.end())
+			continue;
+
+		if (index->second->users == 1)
+			indices.erase(index);
+		else
+			--index->second.write().users;
+	}
+}
+
+/**
+ * @brief					Accumulates the number and formula cells of a range by visiting
+ * 							them. Dense stores are walked in place, sparse stores tile by tile,
+ * 							skipping missing tiles. Runs of adjacent cells go through the
+ * 							vector kernels
+ *
+ * @param [in]	firstRow	Zero-based first row of the range
+ *
+ * @param [in]	firstCol	Zero-based first column of the range
+ *
+ * @param [in]	lastRow		Zero-based last row of the range
+ *
+ * @param [in]	lastCol		Zero-based last column of the range
+ *
+ * @param [in,out] totals	Totals to accumulate the cells into
+ *
+ */
+
+void CellStore::scan(int firstRow, int firstCol, int lastRow, int lastCol, Aggregate::Totals& totals) const {
+	if (firstRow > lastRow)
+		return;
+
+	if (mode == StorageMode::Dense) {
+		scanPages(firstRow, firstCol, lastRow, lastCol, totals);
+		return;
+	}
+
+	for (int tileRow = firstRow / TILE_SIZE; tileRow <= lastRow / TILE_SIZE; ++tileRow) {
+		int top = std::max(firstRow - tileRow * TILE_SIZE, 0), bottom = std::min(lastRow - tileRow * TILE_SIZE, TILE_SIZE - 1);
+		auto end = tiles[tileRow].upper_bound(lastCol / TILE_SIZE);
+
+		for (auto it = tiles[tileRow].lower_bound(firstCol / TILE_SIZE); it != end; ++it) {
+			int left = std::max(firstCol - it->first * TILE_SIZE, 0), right = std::min(lastCol - it->first * TILE_SIZE, TILE_SIZE - 1);
+			int first = top * TILE_SIZE + left;
+
+			accumulateBlock(it->second->values + first, it->second->types + first, bottom - top + 1, right - left + 1, TILE_SIZE, totals);
+		}
+	}
+}
+
+/**
+ * @brief					Accumulates the cells of a range of a dense store. Bands of
+ * 							rows lying within one page go through accumulateBlock() at
+ * 							once, rows crossing a page boundary are split at it
+ *
+ * @param [in]	firstRow	Zero-based first row of the range
+ *
+ * @param [in]	firstCol	Zero-based first column of the range
+ *
+ * @param [in]	lastRow		Zero-based last row of the range
+ *
+ * @param [in]	lastCol		Zero-based last column of the range
+ *
+ * @param [in,out] totals	Totals to accumulate the cells into
+ *
+ */
+
+void CellStore::scanPages(int firstRow, int firstCol, int lastRow, int lastCol, Aggregate::Totals& totals) const {
+	const std::size_t pageSize = CellArray<double>::PAGE_SIZE;
+	int width = lastCol - firstCol + 1;
+
+	for (int row = firstRow; row <= lastRow;) {
+		std::size_t first = (std::size_t)row * columns + firstCol, last = first + width;
+		std::size_t pageEnd = (first / pageSize + 1) * pageSize;
+
+		if (last <= pageEnd) {
+			int height = std::min<std::size_t>(lastRow - row + 1, (pageEnd - last) / columns + 1);
+
+			accumulateBlock(values.at(first), types.at(first), height, width, columns, totals);
+			row += height;
+			continue;
+		}
+
+		for (std::size_t start = first; start < last; start = pageEnd, pageEnd += pageSize)
+			accumulateBlock(values.at(start), types.at(start), 1, std::min(pageEnd, last) - start, columns, totals);
+
+		++row;
+	}
+}
+
+/**
+ * @brief					Checks if a range is narrow enough for its columns to be
+ * 							scanned one by one, and tall enough for an aggregate index
+ * 							to beat scanning them
+ *
+ * @returns					True if the columns of the range should be indexed
+ */
+
+bool CellStore::isIndexed(int firstRow, int firstCol, int lastRow, int lastCol) const {
+	return lastCol - firstCol + 1 < MIN_VECTOR_RUN && lastRow - firstRow + 1 >= MIN_INDEXED_ROWS;
+}
+
+/**
+ * @brief					Fills an aggregate index with the cells of a column
+ *
+ * @param [in]	col			Zero-based column
+ *
+ * @param [out]	index		Index of the column
+ *
+ */
+
+void CellStore::buildIndex(int col, ColumnIndex& index) const {
+	for (int block = 0; block * ColumnIndex::BLOCK_ROWS < rows; ++block)
+		index.initialize(block, blockTotals(col, block));
+
+	index.build();
+}
+
+/**
+ * @brief					Accumulates the number and formula cells of a block of rows
+ * 							of a column, as kept by the aggregate index of the column
+ *
+ * @param [in]	col			Zero-based column
+ *
+ * @param [in]	block		Zero-based block of rows
+ *
+ * @returns					Totals of the block
+ */
+
+Aggregate::Totals CellStore::blockTotals(int col, int block) const {
+	Aggregate::Totals totals;
+	int firstRow = block * ColumnIndex::BLOCK_ROWS;
+
+	scan(firstRow, col, std::min(firstRow + ColumnIndex::BLOCK_ROWS, rows) - 1, col, totals);
+	return totals;
+}
+
+/**
+ * @brief				Accumulates a block of cells laid out row after row. Blocks as
+ * 						wide as their rows are contiguous and accumulated at once, wide
+ * 						blocks row by row and narrow ones column by column
+ *
+ * @param [in]	values	Value of the top left cell
+ *
+ * @param [in]	types	Type tag of the top left cell
+ *
+ * @param [in]	height	Number of rows of the block
+ *
+ * @param [in]	width	Number of columns of the block
+ *
+ * @param [in]	stride	Distance between rows, in cells
+ *
+ * @param [in,out] totals	Totals to accumulate the cells into
+ *
+ */
+
+void accumulateBlock(const double* values, const CellType* types, int height, int width, std::size_t stride, Aggregate::Totals& totals) {
+	if ((std::size_t)width == stride)
+		Aggregate::accumulate(values, types, (std::size_t)height * width, 1, totals);
+
+	else if (width >= MIN_VECTOR_RUN)
+		for (int i = 0; i < height; ++i)
+			Aggregate::accumulate(values + i * stride, types + i * stride, width, 1, totals);
+
+	else
+		for (int j = 0; j < width; ++j)
+			Aggregate::accumulate(values + j, types + j, height, stride, totals);
+}
+
+/**
+ * @brief	Gives the storage layout of the store
+ *
+ * @returns	Dense or sparse mode
+ */
+
+StorageMode CellStore::getMode() const {
+	return mode;
+}
+
+/**
+ * @brief				Clears a cell
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ */
+
+void CellStore::setEmpty(std::size_t index) {
+	assign(index, CellType::Empty, 0.);
+}
+
+/**
+ * @brief				Assigns a number to a cell
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @param [in]	d		Numeric value
+ *
+ */
+
+void CellStore::setNumber(std::size_t index, double d) {
+	assign(index, CellType::Number, d);
+}
+
+/**
+ * @brief				Assigns a text to a cell, interning the text in the pool.
+ * 						The cell is valued the number the text represents, if any
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @param [in]	str		Text, without quotation marks
+ *
+ */
+
+void CellStore::setText(std::size_t index, std::string_view str) {
+	std::uint32_t id = addText(str);
+	assign(index, CellType::Text, texts->number(id), id);
+}
+
+/**
+ * @brief				Marks a cell as an error cell
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ */
+
+void CellStore::setError(std::size_t index) {
+	assign(index, CellType::Error, 0.);
+}
+
+/**
+ * @brief				Assigns the result of a formula to a formula cell
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @param [in]	d		Result of the formula
+ *
+ */
+
+void CellStore::setFormula(std::size_t index, double d) {
+	assign(index, CellType::Formula, d);
+}
+
+/**
+ * @brief					Changes the dimensions and the storage layout of the store,
+ * 							keeping every cell that is still in range at its row and
+ * 							column. Changing only the rows of a dense store resizes its arrays,
+ * 							any other change moves the non-empty cells to a new layout. Aggregate
+ * 							indices are kept only while the dimensions stay the same
+ *
+ * @param [in]	newRows		New number of rows
+ *
+ * @param [in]	newColumns	New number of columns
+ *
+ * @param [in]	newMode		New storage layout
+ *
+ */
+
+void CellStore::reshape(int newRows, int newColumns, StorageMode newMode) {
+	if (mode == StorageMode::Dense && newMode == mode && newColumns == columns) {
+		std::size_t size = (std::size_t)newRows * columns;
+
+		for (std::size_t index = size; index < types.size(); ++index)
+			releaseText(types[index], textIds.empty() ? 0 : textIds[index]);
+
+		types.resize(size, CellType::Empty);
+		values.resize(size, 0.);
+
+		if (!textIds.empty())
+			textIds.resize(size, 0);
+
+		if (newRows != rows)
+			indices.clear();
+
+		rows = newRows;
+		return;
+	}
+
+	countTextReferences();
+
+	CellStore reshaped(newRows, newColumns, newMode);
+	reshaped.texts = std::move(texts);
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = skipEmpty(i, 0); j < columns; j = skipEmpty(i, j + 1)) {
+			std::size_t index = (std::size_t)i * columns + j;
+			CellType cellType = type(index);
+
+			if (cellType == CellType::Empty)
+				continue;
+
+			if (i < newRows && j < newColumns)
+				reshaped.assign((std::size_t)i * newColumns + j, cellType, value(index), textId(index));
+			else
+				reshaped.releaseText(cellType, textId(index));
+		}
+	}
+
+	if (newRows == rows && newColumns == columns)
+		reshaped.indices = std::move(indices);
+
+	*this = std::move(reshaped);
+}
+
+/**
+ * @brief					Moves all cells of another store into consecutive rows of this
+ * 							one, keeping their columns. The target rows should be empty and
+ * 							this store should have at least as many columns as the source.
+ * 							Dense stores of equal width are copied block-wise, texts are
+ * 							interned into the pool of this store
+ *
+ * @param [in,out]	source	Store to move the cells from
+ *
+ * @param [in]		firstRow	Zero-based row of this store receiving the first source row
+ *
+ */
+
+void CellStore::moveRows(CellStore& source, int firstRow) {
+	std::size_t offset = (std::size_t)firstRow * columns;
+
+	if (mode == StorageMode::Dense && source.mode == StorageMode::Dense && source.columns == columns) {
+		types.copy(source.types, offset);
+		values.copy(source.values, offset);
+
+		if (!source.textIds.empty()) {
+			if (textIds.empty())
+				textIds.assign(types.size(), 0);
+
+			for (std::size_t index = 0; index < source.types.size(); ++index)
+				if (source.types[index] == CellType::Text)
+					textIds.set(offset + index, addText(source.texts->text(source.textIds[index])));
+		}
+
+		for (auto& index : indices)
+			buildIndex(index.first, index.second.write());
+
+		return;
+	}
+
+	for (int i = 0; i < source.rows; ++i) {
+		for (int j = source.skipEmpty(i, 0); j < source.columns; j = source.skipEmpty(i, j + 1)) {
+			std::size_t index = (std::size_t)i * source.columns + j;
+			CellType cellType = source.type(index);
+
+			if (cellType == CellType::Empty)
+				continue;
+
+			std::uint32_t id = cellType == CellType::Text ? addText(source.text(index)) : 0;
+			assign((std::size_t)(firstRow + i) * columns + j, cellType, source.value(index), id);
+		}
+	}
+}
+
+/**
+ * @brief	Copies every page, tile and aggregate index still shared with a
+ * 			copy of the store, so threads can then write cells of different
+ * 			pages together
+ *
+ */
+
+void CellStore::unshare() {
+	types.unshare();
+	values.unshare();
+	textIds.unshare();
+
+	for (std::map<int, std::shared_ptr<Tile>>& tileRow : tiles)
+		for (auto& tile : tileRow)
+			if (!isUnshared(tile.second))
+				tile.second = std::make_shared<Tile>(*tile.second);
+
+	for (auto& index : indices)
+		index.second.write();
+}
+
+/**
+ * @brief	Gives an estimate of the memory held by the store in bytes
+ *
+ * @returns	Number of bytes allocated
+ */
+
+std::size_t CellStore::memoryUsage() const {
+	std::size_t bytes = types.capacity() * sizeof(CellType) + values.capacity() * sizeof(double)
+		+ textIds.capacity() * sizeof(std::uint32_t) + tiles.capacity() * sizeof(tiles[0]) + texts->memoryUsage();
+
+	for (const std::map<int, std::shared_ptr<Tile>>& tileRow : tiles)
+		for (const auto& tile : tileRow)
+			bytes += sizeof(Tile) + tile.second->textIds.capacity() * sizeof(std::uint32_t);
+
+	return bytes;
+}
+
+/**
+ * @brief					Finds the tile holding a cell of a sparse store
+ *
+ * @param [in]	index		Absolute index of the cell
+ *
+ * @param [out]	offset		Offset of the cell inside the tile
+ *
+ * @returns					The tile, or nullptr if it is not allocated
+ */
+
+const CellStore::Tile* CellStore::findTile(std::size_t index, int& offset) const {
+	int row = index / columns, col = index % columns;
+	const std::map<int, std::shared_ptr<Tile>>& tileRow = tiles[row / TILE_SIZE];
+	auto it = tileRow.find(col / TILE_SIZE);
+
+	offset = (row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE;
+	return it == tileRow.end() ? nullptr : it->second.get();
+}
+
+/**
+ * @brief				Type tag of a cell of a sparse store
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				The type tag, empty if the tile is not allocated
+ */
+
+CellType CellStore::sparseType(std::size_t index) const {
+	int offset;
+	const Tile* tile = findTile(index, offset);
+
+	return tile == nullptr ? CellType::Empty : tile->types[offset];
+}
+
+/**
+ * @brief				Numeric value of a cell of a sparse store
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				The value, 0 if the tile is not allocated
+ */
+
+double CellStore::sparseValue(std::size_t index) const {
+	int offset;
+	const Tile* tile = findTile(index, offset);
+
+	return tile == nullptr ? 0. : tile->values[offset];
+}
+
+/**
+ * @brief				Interns a text in the pool for a cell about to hold it
+ *
+ * @param [in]	str		Text to store, without quotation marks
+ *
+ * @returns				Text pool id of the text
+ */
+
+std::uint32_t CellStore::addText(std::string_view str) {
+	countTextReferences();
+	return texts.write().intern(str);
+}
+
+/**
+ * @brief				Text pool id of a cell
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ * @returns				The text pool id, 0 if the cell holds no text
+ */
+
+std::uint32_t CellStore::textId(std::size_t index) const {
+	if (mode == StorageMode::Dense)
+		return textIds.empty() ? 0 : textIds[index];
+
+	int offset;
+	const Tile* tile = findTile(index, offset);
+
+	return (tile == nullptr || tile->textIds.empty()) ? 0 : tile->textIds[offset];
+}
+
+/**
+ * @brief					Overwrites a cell, returning its previous text, if any, to
+ * 							the pool. In sparse mode tiles are allocated on the first
+ * 							non-empty write and released once their last cell is cleared.
+ * 							The aggregate index of the column, if any, is updated with it
+ *
+ * @param [in]	index		Absolute index of the cell
+ *
+ * @param [in]	cellType	New type of the cell
+ *
+ * @param [in]	d			New numeric value of the cell
+ *
+ * @param [in]	textId		Text pool id of the new text, 0 if the cell is not a text
+ *
+ */
+
+void CellStore::assign(std::size_t index, CellType cellType, double d, std::uint32_t textId) {
+	auto columnIndex = indices.empty() ? indices.end() : indices.find(index % columns);
+
+	if (columnIndex == indices.end()) {
+		write(index, cellType, d, textId);
+		return;
+	}
+
+	int block = index / columns / ColumnIndex::BLOCK_ROWS;
+	ColumnIndex& changed = columnIndex->second.write();
+	std::lock_guard<std::mutex> guard(changed.lock);
+
+	write(index, cellType, d, textId);
+	changed.update(block, blockTotals(index % columns, block));
+}
+
+/**
+ * @brief					Overwrites a cell as assign() does, leaving aggregate indices
+ * 							as they are. The count of used cells of a sparse tile changes
+ * 							only when a cell turns empty or non-empty, so threads writing
+ * 							formula results into the same tile share no memory but cells
+ *
+ * @param [in]	index		Absolute index of the cell
+ *
+ * @param [in]	cellType	New type of the cell
+ *
+ * @param [in]	d			New numeric value of the cell
+ *
+ * @param [in]	textId		Text pool id of the new text, 0 if the cell is not a text
+ *
+ */
+
+void CellStore::write(std::size_t index, CellType cellType, double d, std::uint32_t textId) {
+	if (mode == StorageMode::Dense) {
+		if (textId != 0 && textIds.empty())
+			textIds.assign(types.size(), 0);
+
+		releaseText(types[index], textIds.empty() ? 0 : textIds[index]);
+		types.set(index, cellType);
+		values.set(index, d);
+
+		if (!textIds.empty())
+			textIds.set(index, textId);
+
+		return;
+	}
+
+	int row = index / columns, col = index % columns;
+	std::map<int, std::shared_ptr<Tile>>& tileRow = tiles[row / TILE_SIZE];
+	auto it = tileRow.find(col / TILE_SIZE);
+
+	if (it == tileRow.end()) {
+		if (cellType == CellType::Empty)
+			return;
+
+		it = tileRow.emplace(col / TILE_SIZE, std::make_shared<Tile>()).first;
+	}
+
+	else if (!isUnshared(it->second))
+		it->second = std::make_shared<Tile>(*it->second);
+
+	Tile& tile = *it->second;
+	int offset = (row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE;
+
+	if (textId != 0 && tile.textIds.empty())
+		tile.textIds.assign(TILE_SIZE * TILE_SIZE, 0);
+
+	releaseText(tile.types[offset], tile.textIds.empty() ? 0 : tile.textIds[offset]);
+	bool wasEmpty = tile.types[offset] == CellType::Empty;
+	tile.types[offset] = cellType;
+	tile.values[offset] = d;
+
+	if (!tile.textIds.empty())
+		tile.textIds[offset] = textId;
+
+	if (wasEmpty == (cellType == CellType::Empty))
+		return;
+
+	tile.used += wasEmpty ? 1 : -1;
+
+	if (tile.used == 0)
+		tileRow.erase(it);
+}
+
+/**
+ * @brief					Returns the text of a text cell back to the pool,
+ * 							no result if the cell holds no text
+ *
+ * @param [in]	cellType	Type of the cell
+ *
+ * @param [in]	textId		Text pool id of the cell
+ *
+ */
+
+void CellStore::releaseText(CellType cellType, std::uint32_t textId) {
+	if (cellType != CellType::Text)
+		return;
+
+	countTextReferences();
+	texts.write().release(textId);
+}
+
+/**
+ * @brief	Counts the cells holding every text of a pool read from a snapshot,
+ * 			which keeps no counts. Done once, before the first text changes,
+ * 			so opening a snapshot does not read every cell
+ *
+ */
+
+void CellStore::countTextReferences() {
+	if (texts->isCounted())
+		return;
+
+	std::vector<std::uint32_t> counts(texts->size(), 0);
+
+	if (mode == StorageMode::Dense) {
+		for (std::size_t index = 0; index < textIds.size(); ++index)
+			if (types[index] == CellType::Text && textIds[index] < counts.size())
+				++counts[textIds[index]];
+	}
+
+	else {
+		for (const std::map<int, std::shared_ptr<Tile>>& tileRow : tiles)
+			for (const auto& tile : tileRow)
+				for (int offset = 0; offset < TILE_SIZE * TILE_SIZE && !tile.second->textIds.empty(); ++offset)
+					if (tile.second->types[offset] == CellType::Text)
+						++counts[tile.second->textIds[offset]];
+	}
+
+	texts.write().setReferences(std::move(counts));
+}
@@ -0,0 +1,467 @@
+#ifndef CELL_STORE_H
+#define CELL_STORE_H
+
+#include "TextPool.h"
+#include "CopyOnWrite.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MappedFile;
+class ColumnIndex;
+
+namespace Aggregate
+{
+	struct Totals;
+}
+
+/**
+ * @enum	CellType
+ *
+ * @brief	Type tag of a table cell
+ *
+ */
+
+enum class CellType : std::uint8_t
+{
+	Empty,
+	Number,
+	Text,
+	Error,
+	Formula
+};
+
+/**
+ * @enum	StorageMode
+ *
+ * @brief	Layout of the cell store. Dense stores keep every cell in flat
+ * 			arrays, sparse stores allocate square tiles of cells only when
+ * 			a cell in them is written
+ *
+ */
+
+enum class StorageMode
+{
+	Dense,
+	Sparse
+};
+
+/**
+ * @class	CellArray
+ *
+ * @brief	Array of cell fields, or of the characters of a printed table, split
+ * 			into pages of fixed size. Copies of an array share its pages, a page
+ * 			is copied on its first change while shared, so copying an array is
+ * 			cheap and a copy keeps the elements as they were. Pages either own
+ * 			their elements or borrow them from a copy-on-write file mapping.
+ * 			Borrowed elements can be written in place, growing the array copies
+ * 			the last page into memory of its own first
+ *
+ */
+
+template <typename T>
+class CellArray
+{
+public:
+	/**
+	 * @brief	Number of elements of a page
+	 */
+
+	static constexpr std::size_t PAGE_SIZE = 1 << 12;
+
+	CellArray() :count(0) {
+	}
+
+	/**
+	 * @brief	Shares the pages of another array
+	 */
+
+	CellArray(const CellArray&) = default;
+	CellArray& operator=(const CellArray&) = delete;
+	CellArray(CellArray&&) = default;
+	CellArray& operator=(CellArray&&) = default;
+
+	const T& operator[](std::size_t index) const {
+		return items[index / PAGE_SIZE][index % PAGE_SIZE];
+	}
+
+	/**
+	 * @brief	Element at given index, followed in memory by the rest of its page
+	 */
+
+	const T* at(std::size_t index) const {
+		return items[index / PAGE_SIZE] + index % PAGE_SIZE;
+	}
+
+	void set(std::size_t index, T value) {
+		writable(index / PAGE_SIZE)[index % PAGE_SIZE] = value;
+	}
+
+	std::size_t size() const {
+		return count;
+	}
+
+	bool empty() const {
+		return count == 0;
+	}
+
+	/**
+	 * @brief	Number of elements allocated in owned pages, shared ones included
+	 */
+
+	std::size_t capacity() const {
+		return PAGE_SIZE * std::count_if(pages.begin(), pages.end(), [](const std::shared_ptr<Page>& page) { return page->owned != nullptr; });
+	}
+
+	void assign(std::size_t size, T value) {
+		pages.clear();
+		items.clear();
+		count = 0;
+		resize(size, value);
+	}
+
+	void resize(std::size_t size, T value) {
+		std::size_t pageCount = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+		if (size > count && count % PAGE_SIZE != 0) {
+			T* last = owned(count / PAGE_SIZE);
+			std::fill(last + count % PAGE_SIZE, last + std::min(PAGE_SIZE, size - count / PAGE_SIZE * PAGE_SIZE), value);
+		}
+
+		pages.resize(std::min(pages.size(), pageCount));
+		items.resize(pages.size());
+
+		while (pages.size() < pageCount) {
+			pages.push_back(allocate());
+			items.push_back(pages.back()->items);
+			std::fill(items.back(), items.back() + PAGE_SIZE, value);
+		}
+
+		count = size;
+	}
+
+	/**
+	 * @brief	Makes the array hold copies of given elements
+	 */
+
+	void assign(const T* elements, std::size_t size) {
+		assign(0, T());
+
+		for (std::size_t first = 0; first < size; first += PAGE_SIZE) {
+			pages.push_back(allocate());
+			items.push_back(pages.back()->items);
+			std::copy(elements + first, elements + std::min(size, first + PAGE_SIZE), items.back());
+		}
+
+		count = size;
+	}
+
+	/**
+	 * @brief	Makes the array use given elements, kept alive by the caller
+	 */
+
+	void borrow(T* elements, std::size_t size) {
+		pages.clear();
+		items.clear();
+
+		for (std::size_t first = 0; first < size; first += PAGE_SIZE) {
+			std::shared_ptr<Page> page = std::make_shared<Page>();
+			page->items = elements + first;
+
+			pages.push_back(page);
+			items.push_back(page->items);
+		}
+
+		count = size;
+	}
+
+	/**
+	 * @brief	Copies every element of another array into consecutive
+	 * 			elements of this one, starting at given index
+	 */
+
+	void copy(const CellArray& source, std::size_t offset) {
+		for (std::size_t done = 0; done < source.count;) {
+			std::size_t from = done, to = offset + done;
+			std::size_t run = std::min({ PAGE_SIZE - from % PAGE_SIZE, PAGE_SIZE - to % PAGE_SIZE, source.count - done });
+
+			std::copy(source.at(from), source.at(from) + run, writable(to / PAGE_SIZE) + to % PAGE_SIZE);
+			done += run;
+		}
+	}
+
+	/**
+	 * @brief	Writes every element to a binary stream, page after page
+	 */
+
+	void write(std::ostream& output) const {
+		for (std::size_t page = 0; page < items.size(); ++page)
+			output.write(reinterpret_cast<const char*>(items[page]), std::min(PAGE_SIZE, count - page * PAGE_SIZE) * sizeof(T));
+	}
+
+	/**
+	 * @brief	Copies every page still shared, so threads can then write
+	 * 			elements of different pages together
+	 */
+
+	void unshare() {
+		for (std::size_t page = 0; page < pages.size(); ++page)
+			writable(page);
+	}
+
+private:
+	/**
+	 * @struct	Page
+	 *
+	 * @brief	Elements of a page, owned or borrowed
+	 */
+
+	struct Page
+	{
+		/**
+		 * @brief	Owned elements, null while borrowing
+		 */
+
+		std::unique_ptr<T[]> owned;
+
+		/**
+		 * @brief	First element, owned or borrowed
+		 */
+
+		T* items;
+	};
+
+	/**
+	 * @brief	Pages, shared by the copies of the array
+	 */
+
+	std::vector<std::shared_ptr<Page>> pages;
+
+	/**
+	 * @brief	First element of every page, so reading skips the page
+	 */
+
+	std::vector<T*> items;
+
+	/**
+	 * @brief	Number of elements
+	 */
+
+	std::size_t count;
+
+	/**
+	 * @brief	Gives the elements of a page to change, copied first if shared
+	 */
+
+	T* writable(std::size_t page) {
+		return isUnshared(pages[page]) ? items[page] : owned(page);
+	}
+
+	/**
+	 * @brief	Gives the elements of a page to change, copied first if shared
+	 * 			or borrowed, so the whole page can be written
+	 */
+
+	T* owned(std::size_t page) {
+		if (pages[page]->owned != nullptr && isUnshared(pages[page]))
+			return items[page];
+
+		std::shared_ptr<Page> copy = allocate();
+		std::copy(items[page], items[page] + std::min(PAGE_SIZE, count - page * PAGE_SIZE), copy->items);
+
+		pages[page] = copy;
+		items[page] = copy->items;
+		return copy->items;
+	}
+
+	/**
+	 * @brief	Allocates an owned page, its elements left as they are
+	 */
+
+	static std::shared_ptr<Page> allocate() {
+		std::shared_ptr<Page> page = std::make_shared<Page>();
+		page->owned.reset(new T[PAGE_SIZE]);
+		page->items = page->owned.get();
+
+		return page;
+	}
+};
+
+/**
+ * @class	CellStore
+ *
+ * @brief	Compact storage for the cells of a table. Every cell is described by
+ * 			a one byte type tag and its numeric value, addressed by the absolute
+ * 			cell index. In dense mode tags and values are kept in two flat arrays,
+ * 			so scanning the table touches contiguous memory only. In sparse mode
+ * 			the same arrays are split into tiles that exist only while they hold
+ * 			a non-empty cell. Text cells additionally keep an id into a pool of
+ * 			interned texts, the id array allocated on the first text write.
+ * 			Copies of a store share its pages, tiles and texts until changed
+ *
+ */
+
+class CellStore
+{
+	friend class Snapshot;
+
+public:
+	CellStore(int, int, StorageMode = StorageMode::Dense);
+	CellStore(const CellStore&);
+	CellStore(CellStore&&);
+	~CellStore();
+	CellStore& operator=(const CellStore&) = delete;
+	CellStore& operator=(CellStore&&);
+
+	/**
+	 * @brief	Type tag of the cell at given absolute index
+	 */
+
+	CellType type(std::size_t index) const {
+		return mode == StorageMode::Dense ? types[index] : sparseType(index);
+	}
+
+	/**
+	 * @brief	Numeric value of the cell at given absolute index. Empty and
+	 * 			error cells are valued 0, text cells hold the number their text
+	 * 			represents, if any, and formula cells their last result
+	 */
+
+	double value(std::size_t index) const {
+		return mode == StorageMode::Dense ? values[index] : sparseValue(index);
+	}
+
+	const std::string& text(std::size_t) const;
+	std::string toString(std::size_t) const;
+	int skipEmpty(int, int) const;
+	void aggregate(int, int, int, int, Aggregate::Totals&) const;
+	void retainIndices(int, int, int, int);
+	void releaseIndices(int, int, int, int);
+	StorageMode getMode() const;
+
+	void setEmpty(std::size_t);
+	void setNumber(std::size_t, double);
+	void setText(std::size_t, std::string_view);
+	void setError(std::size_t);
+	void setFormula(std::size_t, double);
+	void reshape(int, int, StorageMode);
+	void moveRows(CellStore&, int);
+	void unshare();
+
+	std::size_t memoryUsage() const;
+
+private:
+	/**
+	 * @brief	Side length of a sparse storage tile
+	 */
+
+	static const int TILE_SIZE = 32;
+
+	/**
+	 * @struct	Tile
+	 *
+	 * @brief	Square block of cells of a sparse store
+	 */
+
+	struct Tile
+	{
+		CellType types[TILE_SIZE * TILE_SIZE];
+		double values[TILE_SIZE * TILE_SIZE];
+		std::vector<std::uint32_t> textIds;
+
+		/**
+		 * @brief	Number of non-empty cells in the tile
+		 */
+
+		int used;
+
+		Tile();
+	};
+
+	/**
+	 * @brief	Number of table rows
+	 */
+
+	int rows;
+
+	/**
+	 * @brief	Number of table columns, used to split absolute indices
+	 */
+
+	int columns;
+
+	/**
+	 * @brief	Storage layout
+	 */
+
+	StorageMode mode;
+
+	/**
+	 * @brief	Type tag of every cell, dense mode only
+	 */
+
+	CellArray<CellType> types;
+
+	/**
+	 * @brief	Numeric value of every cell, dense mode only
+	 */
+
+	CellArray<double> values;
+
+	/**
+	 * @brief	Text pool id of every cell, 0 if the cell holds no text.
+	 * 			Dense mode only, empty until the first text cell is written
+	 */
+
+	CellArray<std::uint32_t> textIds;
+
+	/**
+	 * @brief	Snapshot file the dense arrays are borrowed from, if any,
+	 * 			kept alive by every copy still sharing borrowed pages
+	 */
+
+	std::shared_ptr<MappedFile> snapshot;
+
+	/**
+	 * @brief	Allocated tiles of every row of tiles keyed by
+	 * 			their column of tiles, sparse mode only
+	 */
+
+	std::vector<std::map<int, std::shared_ptr<Tile>>> tiles;
+
+	/**
+	 * @brief	Interned texts of the text cells
+	 */
+
+	CopyOnWrite<TextPool> texts;
+
+	/**
+	 * @brief	Aggregate indices of the columns narrow ranges are aggregated over,
+	 * 			shared with the copies of the store until changed
+	 */
+
+	std::map<int, CopyOnWrite<ColumnIndex>> indices;
+
+	const Tile* findTile(std::size_t, int&) const;
+	CellType sparseType(std::size_t) const;
+	double sparseValue(std::size_t) const;
+	std::uint32_t textId(std::size_t) const;
+	std::uint32_t addText(std::string_view);
+	void assign(std::size_t, CellType, double, std::uint32_t = 0);
+	void write(std::size_t, CellType, double, std::uint32_t);
+	void releaseText(CellType, std::uint32_t);
+	void countTextReferences();
+	void scan(int, int, int, int, Aggregate::Totals&) const;
+	void scanPages(int, int, int, int, Aggregate::Totals&) const;
+	bool isIndexed(int, int, int, int) const;
+	void buildIndex(int, ColumnIndex&) const;
+	Aggregate::Totals blockTotals(int, int) const;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "ColumnIndex.h"
+#include <algorithm>
+
+void combine(Aggregate::Totals&, const Aggregate::Totals&);
+
+/**
+ * @brief				Constructs the index of a column of empty cells
+ *
+ * @param [in]	rows	Number of rows of the column
+ *
+ */
+
+ColumnIndex::ColumnIndex(int rows) :users(0), blocks((rows + BLOCK_ROWS - 1) / BLOCK_ROWS), nodes(2 * (std::size_t)blocks) {
+}
+
+/**
+ * @brief				Copies an index, along with its users
+ *
+ * @param [in]	other	Index to copy
+ *
+ */
+
+ColumnIndex::ColumnIndex(const ColumnIndex& other) :users(other.users), blocks(other.blocks), nodes(other.nodes) {
+}
+
+/**
+ * @brief					Sets the totals of a block without updating the tree, for
+ * 							filling a new index completed by a call to build()
+ *
+ * @param [in]	block		Zero-based block
+ *
+ * @param [in]	totals		Totals of the cells of the block
+ *
+ */
+
+void ColumnIndex::initialize(int block, const Aggregate::Totals& totals) {
+	nodes[blocks + block] = totals;
+}
+
+/**
+ * @brief	Computes every inner node from the leaves in O(n)
+ *
+ */
+
+void ColumnIndex::build() {
+	for (int i = blocks - 1; i > 0; --i) {
+		nodes[i] = nodes[2 * i];
+		combine(nodes[i], nodes[2 * i + 1]);
+	}
+}
+
+/**
+ * @brief					Replaces the totals of a block and of every node above it.
+ * 							Callers hold the lock of the index
+ *
+ * @param [in]	block		Zero-based block
+ *
+ * @param [in]	totals		New totals of the cells of the block
+ *
+ */
+
+void ColumnIndex::update(int block, const Aggregate::Totals& totals) {
+	int i = blocks + block;
+
+	nodes[i] = totals;
+
+	for (i /= 2; i > 0; i /= 2) {
+		nodes[i] = nodes[2 * i];
+		combine(nodes[i], nodes[2 * i + 1]);
+	}
+}
+
+/**
+ * @brief					Accumulates the cells of a run of blocks, combining at
+ * 							most two nodes per level of the tree. Blocks not being
+ * 							updated can be queried while others are
+ *
+ * @param [in]	firstBlock	Zero-based first block
+ *
+ * @param [in]	lastBlock	Zero-based last block
+ *
+ * @param [in,out] totals	Totals to accumulate the cells into
+ *
+ */
+
+void ColumnIndex::query(int firstBlock, int lastBlock, Aggregate::Totals& totals) const {
+	for (int low = blocks + firstBlock, high = blocks + lastBlock + 1; low < high; low /= 2, high /= 2) {
+		if (low % 2 == 1)
+			combine(totals, nodes[low++]);
+
+		if (high % 2 == 1)
+			combine(totals, nodes[--high]);
+	}
+}
+
+/**
+ * @brief					Adds the totals of a node to other totals
+ *
+ * @param [in,out]	totals	Totals to add to
+ *
+ * @param [in]		node	Totals to add
+ *
+ */
+
+void combine(Aggregate::Totals& totals, const Aggregate::Totals& node) {
+	totals.sum += node.sum;
+	totals.minimum = std::min(totals.minimum, node.minimum);
+	totals.maximum = std::max(totals.maximum, node.maximum);
+	totals.count += node.count;
+}
@@ -0,0 +1,64 @@
+#ifndef COLUMN_INDEX_H
+#define COLUMN_INDEX_H
+
+#include "Aggregate.h"
+#include <mutex>
+#include <vector>
+
+/**
+ * @class	ColumnIndex
+ *
+ * @brief	Segment tree over the blocks of rows of a table column keeping the
+ * 			totals of the number and formula cells of every node, so the sum,
+ * 			minimum, maximum and count of any run of blocks are found in O(log n)
+ * 			and a changed block is folded in in O(log n). Leaves are blocks rather
+ * 			than single rows to keep the tree small, cells of partial blocks at the
+ * 			ends of a range are left to the caller
+ *
+ */
+
+class ColumnIndex
+{
+public:
+	explicit ColumnIndex(int);
+	ColumnIndex(const ColumnIndex&);
+	ColumnIndex& operator=(const ColumnIndex&) = delete;
+
+	void initialize(int, const Aggregate::Totals&);
+	void build();
+	void update(int, const Aggregate::Totals&);
+	void query(int, int, Aggregate::Totals&) const;
+
+	/**
+	 * @brief	Number of rows in a block, a leaf of the tree
+	 */
+
+	static const int BLOCK_ROWS = 16;
+
+	/**
+	 * @brief	Number of range formulas the index is kept for
+	 */
+
+	int users;
+
+	/**
+	 * @brief	Serializes changes of the column, whose paths to the root meet
+	 */
+
+	std::mutex lock;
+
+private:
+	/**
+	 * @brief	Number of blocks, the leaves of the tree
+	 */
+
+	int blocks;
+
+	/**
+	 * @brief	Nodes of the tree, the root at 1 and the leaf of block i at blocks + i
+	 */
+
+	std::vector<Aggregate::Totals> nodes;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "Console.h"
+#include <iostream>
+
+/**
+ * Input stream of the calling thread
+ */
+
+thread_local std::istream* boundIn = &std::cin;
+
+/**
+ * Output stream of the calling thread
+ */
+
+thread_local std::ostream* boundOut = &std::cout;
+
+/**
+ * Error stream of the calling thread, null to write errors to the output stream
+ */
+
+thread_local std::ostream* boundError = nullptr;
+
+/**
+ * Number of failure messages written by the calling thread
+ */
+
+thread_local std::size_t errorCount = 0;
+
+/**
+ * @brief	Gives the stream the calling thread reads commands from
+ *
+ * @returns	Standard input, or the connection of the client served
+ */
+
+std::istream& Console::in() {
+	return *boundIn;
+}
+
+/**
+ * @brief	Gives the stream the calling thread writes messages to
+ *
+ * @returns	Standard output, or the connection of the client served
+ */
+
+std::ostream& Console::out() {
+	return *boundOut;
+}
+
+/**
+ * @brief	Gives the stream the calling thread writes the message of a failed
+ * 			command to, counting the failure
+ *
+ * @returns	Error stream bound, or the output stream if none is
+ */
+
+std::ostream& Console::error() {
+	++errorCount;
+	return boundError != nullptr ? *boundError : *boundOut;
+}
+
+/**
+ * @brief	Gives the number of failure messages the calling thread has written
+ *
+ * @returns	Number of failures
+ */
+
+std::size_t Console::errors() {
+	return errorCount;
+}
+
+/**
+ * @brief				Binds streams to the calling thread
+ *
+ * @param [in]	in		Stream to read commands from
+ *
+ * @param [in]	out		Stream to write messages to
+ *
+ * @param [in]	error	Stream to write failures to, null for the output stream
+ *
+ */
+
+Console::Binding::Binding(std::istream& in, std::ostream& out, std::ostream* error) :previousIn(boundIn), previousOut(boundOut),
+	previousError(boundError) {
+	boundIn = &in;
+	boundOut = &out;
+	boundError = error;
+}
+
+/**
+ * @brief	Destructor binding the streams bound before again
+ *
+ */
+
+Console::Binding::~Binding() {
+	boundIn = previousIn;
+	boundOut = previousOut;
+	boundError = previousError;
+}
@@ -0,0 +1,63 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+/**
+ * @namespace	Console
+ *
+ * @brief		Streams commands are read from and their messages written to by
+ * 				the calling thread. These are the standard streams, unless the thread
+ * 				serves a client of the server, whose connection is bound to the
+ * 				thread instead, so clients served together each get their own output.
+ * 				Messages of failed commands are written to the error stream, which
+ * 				is the output stream unless another one is bound, and counted
+ */
+
+namespace Console
+{
+	std::istream& in();
+	std::ostream& out();
+	std::ostream& error();
+	std::size_t errors();
+
+	/**
+	 * @class	Binding
+	 *
+	 * @brief	Binds streams to the calling thread for as long as it exists,
+	 * 			the streams bound before are bound again when it is destroyed
+	 */
+
+	class Binding
+	{
+	public:
+		Binding(std::istream&, std::ostream&, std::ostream* = nullptr);
+		~Binding();
+
+		Binding(const Binding&) = delete;
+		Binding& operator=(const Binding&) = delete;
+
+	private:
+		/**
+		 * @brief	Input stream bound before
+		 */
+
+		std::istream* previousIn;
+
+		/**
+		 * @brief	Output stream bound before
+		 */
+
+		std::ostream* previousOut;
+
+		/**
+		 * @brief	Error stream bound before, null if it was the output stream
+		 */
+
+		std::ostream* previousError;
+	};
+};
+
+#endif
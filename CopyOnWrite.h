@@ -0,0 +1,74 @@
+#ifndef COPY_ON_WRITE_H
+#define COPY_ON_WRITE_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief			Checks if a holder is the only one left sharing a value, so
+ * 					it can change the value in place. Holders dropped by other
+ * 					threads are done reading it once this returns true
+ *
+ * @param [in]	shared	Holder of the value
+ *
+ * @returns			True if no other holder shares the value
+ */
+
+template <typename T>
+bool isUnshared(const std::shared_ptr<T>& shared) {
+	if (shared.use_count() != 1)
+		return false;
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return true;
+}
+
+/**
+ * @class	CopyOnWrite
+ *
+ * @brief	Value shared by the copies of its holder until one of them changes
+ * 			it. Reading never copies, a change copies the value first if some
+ * 			other holder still shares it, so a version of a table taken for a
+ * 			reader keeps the value as it was while the table goes on changing
+ *
+ */
+
+template <typename T>
+class CopyOnWrite
+{
+public:
+	CopyOnWrite() :value(std::make_shared<T>()) {
+	}
+
+	explicit CopyOnWrite(T&& initial) :value(std::make_shared<T>(std::move(initial))) {
+	}
+
+	const T& operator*() const {
+		return *value;
+	}
+
+	const T* operator->() const {
+		return value.get();
+	}
+
+	/**
+	 * @brief	Gives the value to change, copied first if it is shared
+	 */
+
+	T& write() {
+		if (!isUnshared(value))
+			value = std::make_shared<T>(*value);
+
+		return *value;
+	}
+
+private:
+	/**
+	 * @brief	Value, shared by the copies of the holder
+	 */
+
+	std::shared_ptr<T> value;
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include "EditJournal.h"
+#include "BackgroundSaver.h"
+#include "MappedFile.h"
+#include "Stats.h"
+#include "Console.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+void appendInteger(std::string&, std::uint32_t);
+std::uint32_t readInteger(const char*);
+
+/**
+ * @brief	Journal format version written to and expected in the header
+ */
+
+const std::uint32_t JOURNAL_VERSION = 1;
+
+/**
+ * @brief	Written as is, reads back differently on machines of another byte order
+ */
+
+const std::uint32_t JOURNAL_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief	Size of the row, column and value length of an edit record, in bytes
+ */
+
+const std::size_t RECORD_HEADER_SIZE = 3 * sizeof(std::uint32_t);
+
+/**
+ * @brief	Constructs a journal attached to no data file
+ *
+ */
+
+EditJournal::EditJournal() :pendingCount(0), length(0) {
+}
+
+/**
+ * @brief				Attaches the journal of given data file, dropping any
+ * 						edits not committed to the previous one
+ *
+ * @param [in]	file	Data file
+ *
+ */
+
+void EditJournal::attach(const std::string& file) {
+	std::lock_guard<std::mutex> guard(lock);
+	path = pathOf(file);
+	pending.clear();
+	pendingCount = 0;
+
+	std::error_code error;
+	length = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+
+	if (error)
+		length = 0;
+}
+
+/**
+ * @brief	Detaches the journal, dropping any edits not committed
+ *
+ */
+
+void EditJournal::detach() {
+	std::lock_guard<std::mutex> guard(lock);
+	path.clear();
+	pending.clear();
+	pendingCount = 0;
+	length = 0;
+}
+
+/**
+ * @brief				Applies the committed edits of the journal to a table loaded
+ * 						from its data file, with a single recalculation. Units torn or
+ * 						corrupted by a crash, and everything after them, are cut off
+ * 						the journal. A journal with an invalid header is discarded
+ *
+ * @param [in]	table	Table loaded from the data file
+ *
+ * @returns				Number of edits applied
+ */
+
+std::size_t EditJournal::replay(Table& table) {
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (path.empty() || length == 0)
+		return 0;
+
+	std::size_t applied = 0;
+	std::size_t valid = sizeof(Header);
+
+	{
+		const MappedFile data(path);
+
+		if (!data.isOpen())
+			return 0;
+
+		Header header = {};
+
+		if (data.size() >= sizeof(Header))
+			std::memcpy(&header, data.data(), sizeof(Header));
+
+		if (std::memcmp(header.magic, "ETJ", 4) != 0 || header.version != JOURNAL_VERSION || header.byteOrder != JOURNAL_BYTE_ORDER) {
+			Console::error() << "Invalid journal file " << path << "! Journal discarded" << std::endl;
+			valid = 0;
+		}
+
+		std::vector<CellEdit> edits;
+
+		while (valid != 0 && data.size() - valid >= sizeof(UnitHeader)) {
+			UnitHeader unit;
+			std::memcpy(&unit, data.data() + valid, sizeof(UnitHeader));
+
+			const char* position = data.data() + valid + sizeof(UnitHeader);
+
+			if (unit.length > data.size() - valid - sizeof(UnitHeader) || checksum(position, unit.length) != unit.checksum)
+				break;
+
+			const char* end = position + unit.length;
+			std::size_t unitStart = edits.size();
+
+			while (end - position >= (std::ptrdiff_t)RECORD_HEADER_SIZE) {
+				std::uint32_t valueLength = readInteger(position + 2 * sizeof(std::uint32_t));
+
+				if (valueLength > (std::size_t)(end - position) - RECORD_HEADER_SIZE)
+					break;
+
+				edits.push_back({ (int)readInteger(position), (int)readInteger(position + sizeof(std::uint32_t)),
+					std::string_view(position + RECORD_HEADER_SIZE, valueLength) });
+				position += RECORD_HEADER_SIZE + valueLength;
+			}
+
+			if (position != end) {
+				edits.resize(unitStart);
+				break;
+			}
+
+			valid += sizeof(UnitHeader) + unit.length;
+		}
+
+		table.setCells(edits);
+		applied = edits.size();
+
+		if (valid == data.size())
+			return applied;
+	}
+
+	std::error_code error;
+	std::filesystem::resize_file(path, valid, error);
+	length = error ? length : valid;
+
+	if (valid != 0)
+		Console::out() << "Journal " << path << " ends in an incomplete save! Incomplete edits dropped" << std::endl;
+
+	return applied;
+}
+
+/**
+ * @brief				Records an edit, written to the journal on the next commit
+ *
+ * @param [in]	edit	Edit applied to the table
+ *
+ */
+
+void EditJournal::record(const CellEdit& edit) {
+	appendInteger(pending, (std::uint32_t)edit.row);
+	appendInteger(pending, (std::uint32_t)edit.col);
+	appendInteger(pending, (std::uint32_t)edit.value.size());
+	pending.append(edit.value);
+	++pendingCount;
+}
+
+/**
+ * @brief	Appends the recorded edits to the journal as a single unit and flushes
+ * 			it to disk. If writing fails the journal is restored to its previous
+ * 			size and the edits are kept for the next commit
+ *
+ * @returns	True if the edits are in the journal, false otherwise
+ */
+
+bool EditJournal::commit() {
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (pendingCount == 0)
+		return true;
+
+	if (length == 0 && !writeHeader())
+		return false;
+
+	UnitHeader unit = { (std::uint32_t)pending.size(), checksum(pending.data(), pending.size()) };
+	std::ofstream output(path, std::ios::binary | std::ios::app);
+
+	output.write(reinterpret_cast<const char*>(&unit), sizeof(UnitHeader));
+	output.write(pending.data(), pending.size());
+	output.close();
+
+	if (!output || !BackgroundSaver::syncPath(path)) {
+		std::error_code error;
+		std::filesystem::resize_file(path, length, error);
+		return false;
+	}
+
+	length += sizeof(UnitHeader) + pending.size();
+	Stats::add(Stats::BytesWritten, sizeof(UnitHeader) + pending.size());
+	pending.clear();
+	pendingCount = 0;
+	return true;
+}
+
+/**
+ * @brief	Checks if edits were recorded since the last commit
+ *
+ * @returns	True if there are edits left to commit
+ */
+
+bool EditJournal::hasPending() const {
+	return pendingCount != 0;
+}
+
+/**
+ * @brief				Empties the journal once its edits are in the data file,
+ * 						unless more edits were committed in the meantime or
+ * 						another data file was attached
+ *
+ * @param [in]	file	Data file written
+ *
+ * @param [in]	size	Journal size when the table written to the data file was taken
+ *
+ */
+
+void EditJournal::reset(const std::string& file, std::uintmax_t size) {
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (path != pathOf(file) || length != size || length <= sizeof(Header))
+		return;
+
+	std::error_code error;
+	std::filesystem::resize_file(path, sizeof(Header), error);
+
+	if (!error)
+		length = sizeof(Header);
+}
+
+/**
+ * @brief	Size of the journal file, in bytes
+ */
+
+std::uintmax_t EditJournal::size() {
+	std::lock_guard<std::mutex> guard(lock);
+	return length;
+}
+
+/**
+ * @brief				Journal file of given data file
+ */
+
+std::string EditJournal::pathOf(const std::string& file) {
+	return file + ".wal";
+}
+
+/**
+ * @brief	Creates the journal file holding the header only
+ *
+ * @returns	True if created, false otherwise
+ */
+
+bool EditJournal::writeHeader() {
+	Header header = { { 'E', 'T', 'J', '\0' }, JOURNAL_VERSION, JOURNAL_BYTE_ORDER };
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+
+	output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	output.close();
+
+	if (!output)
+		return false;
+
+	length = sizeof(Header);
+	return true;
+}
+
+/**
+ * @brief				FNV-1a hash of given bytes
+ *
+ * @param [in]	bytes	First byte
+ *
+ * @param [in]	size	Number of bytes
+ *
+ * @returns				32 bit hash
+ */
+
+std::uint32_t EditJournal::checksum(const char* bytes, std::size_t size) {
+	std::uint32_t hash = 2166136261u;
+
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= (unsigned char)bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief				Appends the bytes of a 32 bit integer in machine order
+ *
+ */
+
+void appendInteger(std::string& bytes, std::uint32_t value) {
+	bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief				Reads a 32 bit integer in machine order from unaligned bytes
+ *
+ */
+
+std::uint32_t readInteger(const char* bytes) {
+	std::uint32_t value;
+	std::memcpy(&value, bytes, sizeof(value));
+	return value;
+}
@@ -0,0 +1,107 @@
+#ifndef EDIT_JOURNAL_H
+#define EDIT_JOURNAL_H
+
+#include "Table.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * @class	EditJournal
+ *
+ * @brief	Append-only journal of cell edits kept next to a data file, as
+ * 			<file>.wal. Edits are recorded in memory as they are made and
+ * 			appended to the journal together, as a single checksummed unit,
+ * 			when the table is saved, so saving costs as much as the edits
+ * 			made since the last save. Opening the data file replays the
+ * 			complete units over it, a unit torn by a crash is dropped.
+ * 			Compacting writes the whole table into the data file and resets
+ * 			the journal, replaying edits already in the data file changes
+ * 			nothing, so the journal may be reset any time after that
+ *
+ */
+
+class EditJournal
+{
+public:
+	EditJournal();
+
+	EditJournal(const EditJournal&) = delete;
+	EditJournal& operator=(const EditJournal&) = delete;
+
+	void attach(const std::string&);
+	void detach();
+	std::size_t replay(Table&);
+	void record(const CellEdit&);
+	bool commit();
+	bool hasPending() const;
+	void reset(const std::string&, std::uintmax_t);
+	std::uintmax_t size();
+
+	static std::string pathOf(const std::string&);
+
+private:
+	/**
+	 * @struct	Header
+	 *
+	 * @brief	Leading bytes of every journal file
+	 */
+
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+	};
+
+	/**
+	 * @struct	UnitHeader
+	 *
+	 * @brief	Leading bytes of every unit of edits, followed by the edit records.
+	 * 			Every record is the cell row and column as 32 bit integers, the
+	 * 			value length as a 32 bit unsigned integer and the value bytes
+	 */
+
+	struct UnitHeader
+	{
+		std::uint32_t length;
+		std::uint32_t checksum;
+	};
+
+	/**
+	 * @brief	Journal file, empty while no data file is attached
+	 */
+
+	std::string path;
+
+	/**
+	 * @brief	Records of the edits made since the last commit
+	 */
+
+	std::string pending;
+
+	/**
+	 * @brief	Number of edits made since the last commit
+	 */
+
+	std::size_t pendingCount;
+
+	/**
+	 * @brief	Size of the journal file, 0 if it does not exist yet
+	 */
+
+	std::uintmax_t length;
+
+	/**
+	 * @brief	Guards the journal file and its size, reset from the saver thread
+	 */
+
+	std::mutex lock;
+
+	bool writeHeader();
+
+	static std::uint32_t checksum(const char*, std::size_t);
+};
+
+#endif
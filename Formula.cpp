@@ -0,0 +1,119 @@
+#include "Formula.h"
+#include "StringUtils.h"
+#include <algorithm>
+#include <string>
+#include <cassert>
+
+/**
+ * @brief			  Gives precedence value of a mathematical operator as follows:
+ * 					  '^' is valued 4, '*' and '/' - 3 and '+' or '-' - 2
+ *
+ * @param [in]	 ch	  Character that is mathematical operator
+ *
+ * @returns			  Operator precedence value
+ */
+
+int precedence(char ch) {
+	return (ch == '*' || ch == '/') ? 3 : (ch == '^') ? 4 : 2;
+}
+
+/**
+ * @brief					Compiles a formula to a postfix program using Shunting-yard
+ * 							algorithm. The text should be a valid formula as denoted by
+ * 							StringUtils::isFormula. References to cells out of the table
+ * 							are compiled to the constant 0, ranges are clipped to the table.
+ * 							References to other sheets are kept by sheet name and cell
+ *
+ * @param [in]	str			Formula text
+ *
+ * @param [in]	rows		Number of rows of the table the formula belongs to
+ *
+ * @param [in]	columns		Number of columns of the table the formula belongs to
+ *
+ */
+
+Formula::Formula(std::string_view str, int rows, int columns) : source(str) {
+	std::vector<char> ops;
+	int height = 0;
+	size_t pos = 1;
+
+	auto emitOperator = [&]() {
+		char op = ops.back();
+		ops.pop_back();
+
+		Instruction instruction;
+		instruction.code = (op == '+') ? Instruction::Add : (op == '-') ? Instruction::Subtract : (op == '*') ? Instruction::Multiply
+			: (op == '/') ? Instruction::Divide : Instruction::Power;
+		program.push_back(instruction);
+		--height;
+	};
+
+	for (size_t i = 1; i <= str.size(); ++i) {
+		if (i < str.size() && !StringUtils::isMathOperator(str.at(i)))
+			continue;
+
+		std::string_view operand = str.substr(pos, i - pos);
+		Instruction instruction;
+		instruction.code = Instruction::Constant;
+		instruction.value = 0.;
+
+		if (operand.back() == ')') {
+			std::string_view name = operand.substr(0, operand.find('('));
+			std::pair<std::pair<int, int>, std::pair<int, int>> range
+				= StringUtils::parseCellRange(operand.substr(name.size() + 1, operand.size() - name.size() - 2)).value();
+
+			instruction.code = (name == "SUM") ? Instruction::Sum : (name == "AVG") ? Instruction::Average : (name == "MIN") ? Instruction::Minimum
+				: (name == "MAX") ? Instruction::Maximum : Instruction::Count;
+			instruction.index = ranges.size();
+			ranges.push_back({ range.first.first - 1, range.first.second - 1, std::min(range.second.first, rows) - 1, std::min(range.second.second, columns) - 1 });
+		}
+
+		else if (operand.find('!') != std::string_view::npos) {
+			std::pair<std::string_view, std::pair<int, int>> reference = StringUtils::parseSheetReference(operand).value();
+
+			instruction.code = Instruction::External;
+			instruction.index = externals.size();
+			externals.push_back({ std::string(reference.first), reference.second.first, reference.second.second, 0 });
+		}
+
+		else if (operand.front() == 'R') {
+			std::pair<int, int> cell = StringUtils::parseCellReference(operand).value();
+
+			if (cell.first <= rows && cell.second <= columns) {
+				instruction.code = Instruction::Reference;
+				instruction.index = (std::size_t)(cell.first - 1) * columns + cell.second - 1;
+				references.push_back(instruction.index);
+			}
+		}
+
+		else
+			instruction.value = StringUtils::parseNumber(operand).value();
+
+		program.push_back(instruction);
+		++height;
+		assert(height <= STACK_SIZE);
+
+		if (i < str.size()) {
+			while (!ops.empty() && precedence(ops.back()) >= precedence(str.at(i)))
+				emitOperator();
+
+			ops.push_back(str.at(i));
+		}
+
+		pos = i + 1;
+	}
+
+	while (!ops.empty())
+		emitOperator();
+}
+
+/**
+ * @brief	 Gives the text the formula was compiled from
+ *
+ * @returns	 Formula text
+ *
+ */
+
+const std::string& Formula::getSource() const {
+	return source;
+}
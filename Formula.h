@@ -0,0 +1,155 @@
+#ifndef FORMULA_H
+#define FORMULA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class	Formula
+ *
+ * @brief	Class representing a compiled table formula. Keeps the formula
+ * 			text along with a postfix program whose operands are constants,
+ * 			absolute indices of the referenced cells or aggregates of ranges
+ * 			of cells, resolved once at compile time for the table the formula
+ * 			belongs to, or cells of other sheets, resolved by the table. Has only
+ * 			private constructor and cannot be manually instantiated
+ *
+ */
+
+class Formula
+{
+	friend class Table;
+	friend class Snapshot;
+
+public:
+	const std::string& getSource() const;
+
+	/**
+	 * @brief	Capacity of the evaluation stack. Operators are applied as soon as
+	 * 			an operator of lower or equal precedence follows, so at most one
+	 * 			pending operator per precedence level is kept and a program never
+	 * 			holds more than four operands on the stack
+	 */
+
+	static const int STACK_SIZE = 8;
+
+private:
+	Formula() = default;
+	Formula(std::string_view, int, int);
+
+	/**
+	 * @struct	Instruction
+	 *
+	 * @brief	Single step of a postfix formula program
+	 */
+
+	struct Instruction
+	{
+		/**
+		 * @brief	Operation performed by the instruction
+		 */
+
+		enum Code : std::uint8_t
+		{
+			Constant,
+			Reference,
+			Add,
+			Subtract,
+			Multiply,
+			Divide,
+			Power,
+			Sum,
+			Average,
+			Minimum,
+			Maximum,
+			Count,
+			External
+		} code;
+
+		union
+		{
+			/**
+			 * @brief	Value pushed by a constant
+			 */
+
+			double value;
+
+			/**
+			 * @brief	Absolute index of the cell pushed by a reference, position
+			 * 			of the range aggregated by an aggregate or of the cell
+			 * 			of another sheet pushed by an external reference
+			 */
+
+			std::size_t index;
+		};
+	};
+
+	/**
+	 * @struct	Range
+	 *
+	 * @brief	Zero-based first and last row and column of a range of cells,
+	 * 			clipped to the table. Empty if the first row or column is past
+	 * 			the last one
+	 */
+
+	struct Range
+	{
+		int firstRow, firstColumn, lastRow, lastColumn;
+	};
+
+	/**
+	 * @struct	External
+	 *
+	 * @brief	Cell of another sheet, as '<sheet>!R<row>C<col>'. The sheet is
+	 * 			resolved by the table the formula belongs to, the cell when
+	 * 			evaluated, so references out of the sheet push 0
+	 */
+
+	struct External
+	{
+		std::string sheet;
+		int row, col;
+
+		/**
+		 * @brief	Position of the sheet among the sheets the table refers to
+		 */
+
+		std::size_t slot;
+	};
+
+	/**
+	 * @brief	Formula text
+	 */
+
+	std::string source;
+
+	/**
+	 * @brief	Formula program in postfix order
+	 */
+
+	std::vector<Instruction> program;
+
+	/**
+	 * @brief	Ranges of cells aggregated by the program
+	 */
+
+	std::vector<Range> ranges;
+
+	/**
+	 * @brief	Cells of other sheets referred to by the program
+	 */
+
+	std::vector<External> externals;
+
+	/**
+	 * @brief	Absolute indices of the existing cells the formula refers to,
+	 * 			without duplicates. Cells of ranges are not listed
+	 */
+
+	std::vector<std::size_t> references;
+};
+
+#endif
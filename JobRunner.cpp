@@ -0,0 +1,167 @@
+#include "JobRunner.h"
+#include "Console.h"
+#include <sstream>
+#include <utility>
+
+/**
+ * @brief				Constructs a runner running jobs inline until set to
+ * 						run them in the background
+ *
+ * @param [in]	execute	Runs a command queued behind a job
+ *
+ */
+
+JobRunner::JobRunner(std::function<void(std::string&)> execute) :execute(std::move(execute)), background(false), busy(false) {
+}
+
+/**
+ * @brief	Destructor joining the worker, if any
+ *
+ */
+
+JobRunner::~JobRunner() {
+	if (worker.joinable())
+		worker.join();
+}
+
+/**
+ * @brief					Sets if jobs run in the background, which only the
+ * 							console does, or inline on the calling thread
+ *
+ * @param [in]	background	True to run jobs in the background
+ *
+ */
+
+void JobRunner::setBackground(bool background) {
+	std::lock_guard<std::mutex> guard(lock);
+	this->background = background;
+}
+
+/**
+ * @brief					Runs a job, in the background if set to and inline otherwise.
+ * 							A job started by a command queued behind another runs inline
+ * 							on the worker, as the console is already free
+ *
+ * @param [in]	progress	Progress of the job, printed and cancelled while it runs
+ *
+ * @param [in]	work		Job to run
+ *
+ */
+
+void JobRunner::run(std::shared_ptr<Progress> progress, std::function<void()> work) {
+	std::unique_lock<std::mutex> guard(lock);
+
+	if (background && !busy) {
+		busy = true;
+		this->progress = std::move(progress);
+		start(std::move(work));
+		return;
+	}
+
+	std::shared_ptr<Progress> previous = std::exchange(this->progress, std::move(progress));
+	guard.unlock();
+
+	work();
+
+	guard.lock();
+	this->progress = std::move(previous);
+}
+
+/**
+ * @brief	Checks if a job runs, so commands read meanwhile are to be queued
+ *
+ * @returns	True while a job or the commands queued behind it run
+ */
+
+bool JobRunner::isBusy() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return busy;
+}
+
+/**
+ * @brief				Queues a command behind the running job. If the job ended
+ * 						since checked, the worker is started again to run it, so
+ * 						commands still run in the order they were read
+ *
+ * @param [in]	line	Command, as typed
+ *
+ * @param [in]	input	Lines the command reads from the console, read beforehand
+ *
+ */
+
+void JobRunner::enqueue(const std::string& line, const std::string& input) {
+	std::lock_guard<std::mutex> guard(lock);
+	queued.push_back({ line, input });
+
+	if (!busy) {
+		busy = true;
+		start(nullptr);
+	}
+}
+
+/**
+ * @brief	Gives the progress of the running job
+ *
+ * @returns	Progress of the job, null if none runs
+ */
+
+std::shared_ptr<Progress> JobRunner::current() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return progress;
+}
+
+/**
+ * @brief	Blocks until the running job and the commands queued behind it are done
+ *
+ */
+
+void JobRunner::wait() {
+	std::unique_lock<std::mutex> guard(lock);
+	idle.wait(guard, [this] { return !busy; });
+}
+
+/**
+ * @brief				Starts the worker on a job. The previous worker, if any,
+ * 						has left the runner idle and is done with the lock
+ *
+ * @param [in]	work	Job to run, null to only run the queued commands
+ *
+ */
+
+void JobRunner::start(std::function<void()> work) {
+	if (worker.joinable())
+		worker.join();
+
+	worker = std::thread(&JobRunner::serve, this, std::move(work));
+}
+
+/**
+ * @brief				Main function of the worker: runs the job, then the commands
+ * 						queued behind it, each reading the console input read for it
+ *
+ * @param [in]	work	Job to run, null if none
+ *
+ */
+
+void JobRunner::serve(std::function<void()> work) {
+	if (work)
+		work();
+
+	std::unique_lock<std::mutex> guard(lock);
+	progress = nullptr;
+
+	while (!queued.empty()) {
+		Command command = std::move(queued.front());
+		queued.pop_front();
+		guard.unlock();
+
+		std::istringstream input(command.input);
+		Console::Binding binding(input, Console::out());
+		execute(command.line);
+
+		guard.lock();
+	}
+
+	busy = false;
+	idle.notify_all();
+}
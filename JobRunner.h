@@ -0,0 +1,107 @@
+#ifndef JOB_RUNNER_H
+#define JOB_RUNNER_H
+
+#include "Progress.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @class	JobRunner
+ *
+ * @brief	Runs long console commands, such as opening a large file, as jobs on
+ * 			a background thread, so the console keeps reading commands meanwhile.
+ * 			Commands read while a job runs are queued and run after it on the
+ * 			same thread, in the order typed, so they see the job done. Commands
+ * 			read while no job runs are run by the console thread as before. The
+ * 			progress of the running job can be printed and the job cancelled.
+ * 			Outside of the console, jobs run inline on the calling thread
+ *
+ */
+
+class JobRunner
+{
+public:
+	JobRunner(std::function<void(std::string&)>);
+	~JobRunner();
+
+	JobRunner(const JobRunner&) = delete;
+	JobRunner& operator=(const JobRunner&) = delete;
+
+	void setBackground(bool);
+	void run(std::shared_ptr<Progress>, std::function<void()>);
+	bool isBusy() const;
+	void enqueue(const std::string&, const std::string& = "");
+	std::shared_ptr<Progress> current() const;
+	void wait();
+
+private:
+	/**
+	 * @struct	Command
+	 *
+	 * @brief	Command read while a job runs, with the lines it reads from the console
+	 */
+
+	struct Command
+	{
+		std::string line;
+		std::string input;
+	};
+
+	/**
+	 * @brief	Runs a queued command
+	 */
+
+	std::function<void(std::string&)> execute;
+
+	/**
+	 * @brief	True if jobs run in the background, false to run them inline
+	 */
+
+	bool background;
+
+	/**
+	 * @brief	True while the worker runs a job or the commands queued behind it
+	 */
+
+	bool busy;
+
+	/**
+	 * @brief	Commands waiting for the running job
+	 */
+
+	std::deque<Command> queued;
+
+	/**
+	 * @brief	Progress of the running job, null if none
+	 */
+
+	std::shared_ptr<Progress> progress;
+
+	/**
+	 * @brief	Guards the members above
+	 */
+
+	mutable std::mutex lock;
+
+	/**
+	 * @brief	Signalled when the worker is done with the queued commands
+	 */
+
+	std::condition_variable idle;
+
+	/**
+	 * @brief	Thread running the jobs and the commands queued behind them
+	 */
+
+	std::thread worker;
+
+	void start(std::function<void()>);
+	void serve(std::function<void()>);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+#include <string>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief				  Maps a file into memory for reading
+ *
+ * @param [in]  file	  File to map
+ *
+ * @param [in]  writable  If set to true (false by default), the view can be
+ * 						  written to without changing the file
+ *
+ */
+
+MappedFile::MappedFile(const std::string& file, bool writable) : opened(false), bytes(nullptr), length(0) {
+#ifdef _WIN32
+	std::ifstream myFile(file, std::ios::in | std::ios::binary);
+
+	if (!myFile.is_open())
+		return;
+
+	buffer.assign(std::istreambuf_iterator<char>(myFile), std::istreambuf_iterator<char>());
+	bytes = buffer.data();
+	length = buffer.size();
+	opened = true;
+#else
+	int descriptor = ::open(file.c_str(), O_RDONLY);
+
+	if (descriptor < 0)
+		return;
+
+	struct stat info;
+
+	if (fstat(descriptor, &info) == 0) {
+		length = info.st_size;
+
+		if (length == 0)
+			opened = true;
+
+		else {
+			void* mapping = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+			if (mapping != MAP_FAILED) {
+				madvise(mapping, length, writable ? MADV_NORMAL : MADV_SEQUENTIAL);
+				bytes = static_cast<char*>(mapping);
+				opened = true;
+			}
+		}
+	}
+
+	::close(descriptor);
+#endif
+}
+
+/**
+ * @brief	Unmaps the file
+ *
+ */
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+	if (bytes != nullptr)
+		munmap(bytes, length);
+#endif
+}
+
+/**
+ * @brief	 Check if the file was opened successfully
+ *
+ * @returns	 True if the file contents are available, false otherwise
+ *
+ */
+
+bool MappedFile::isOpen() const {
+	return opened;
+}
+
+/**
+ * @brief	 Gives the file contents
+ *
+ * @returns	 Pointer to the first byte of the file, nullptr if the file is empty
+ *
+ */
+
+const char* MappedFile::data() const {
+	return bytes;
+}
+
+/**
+ * @brief	 Gives the file contents for writing, if mapped writable
+ *
+ * @returns	 Pointer to the first byte of the file, nullptr if the file is empty
+ *
+ */
+
+char* MappedFile::data() {
+	return bytes;
+}
+
+/**
+ * @brief	 Gives the file size
+ *
+ * @returns	 Number of bytes of the file
+ *
+ */
+
+std::size_t MappedFile::size() const {
+	return length;
+}
@@ -0,0 +1,60 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @class	MappedFile
+ *
+ * @brief	Read-only view of a whole file mapped into memory. Pages are
+ * 			loaded by the OS on first access, so opening costs nothing
+ * 			proportional to the file size. A writable view is private to
+ * 			the process: written pages are copied and never reach the file.
+ * 			Where memory mapping is not available the file is read into a
+ * 			buffer instead
+ *
+ */
+
+class MappedFile
+{
+public:
+	MappedFile(const std::string&, bool = false);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const;
+	const char* data() const;
+	char* data();
+	std::size_t size() const;
+
+private:
+	/**
+	 * @brief	True if the file was opened successfully
+	 */
+
+	bool opened;
+
+	/**
+	 * @brief	First byte of the file contents
+	 */
+
+	char* bytes;
+
+	/**
+	 * @brief	File size in bytes
+	 */
+
+	std::size_t length;
+
+	/**
+	 * @brief	File contents, used only when memory mapping is not available
+	 */
+
+	std::vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "Progress.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief				Starts counting the progress of a command
+ *
+ * @param [in]	task	Command, as typed
+ *
+ * @param [in]	unit	What the work is counted in
+ *
+ */
+
+Progress::Progress(const std::string& task, const char* unit) :task(task), unit(unit), done(0), total(0), state(Running),
+	start(std::chrono::steady_clock::now()) {
+}
+
+/**
+ * @brief				Sets the amount of work expected
+ *
+ * @param [in]	amount	Amount of work, in the unit of the progress
+ *
+ */
+
+void Progress::expect(std::uint64_t amount) {
+	total.store(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief				Counts work done. Called by any thread doing the work
+ *
+ * @param [in]	amount	Amount of work done since last counted
+ *
+ */
+
+void Progress::advance(std::uint64_t amount) {
+	done.fetch_add(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief	Asks the work to stop at the next step it checks for it
+ *
+ * @returns	False if the work has already committed
+ */
+
+bool Progress::cancel() {
+	State running = Running;
+	return state.compare_exchange_strong(running, Cancelled) || running == Cancelled;
+}
+
+/**
+ * @brief	Marks the work as past cancelling, before it starts changing
+ * 			what it cannot restore
+ *
+ * @returns	False if the work was cancelled first and is to stop instead
+ */
+
+bool Progress::commit() {
+	State running = Running;
+	return state.compare_exchange_strong(running, Committed) || running == Committed;
+}
+
+/**
+ * @brief	Checks if the work is to stop
+ *
+ * @returns	True once cancelled
+ */
+
+bool Progress::isCancelled() const {
+	return state.load(std::memory_order_relaxed) == Cancelled;
+}
+
+/**
+ * @brief	Gives the command the progress is of
+ *
+ * @returns	Command, as typed
+ */
+
+const std::string& Progress::getTask() const {
+	return task;
+}
+
+/**
+ * @brief	Describes the progress, as the command, the work done out of
+ * 			the work expected and the time taken so far
+ *
+ * @returns	Description, e.g. "open big.txt: 1048576 of 4194304 bytes (25%), 1.5 s"
+ */
+
+std::string Progress::describe() const {
+	std::uint64_t amount = done.load(std::memory_order_relaxed), expected = total.load(std::memory_order_relaxed);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::ostringstream output;
+	output << task << ": " << amount;
+
+	if (expected != 0)
+		output << " of " << expected << " " << unit << " (" << std::min<std::uint64_t>(amount * 100 / expected, 100) << "%)";
+	else
+		output << " " << unit;
+
+	output << ", " << std::fixed << std::setprecision(1) << seconds << " s";
+	return output.str();
+}
@@ -0,0 +1,88 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class	Progress
+ *
+ * @brief	Progress of a long command running in the background, advanced by
+ * 			the threads doing the work and read by the console asking for it.
+ * 			Cancelling only raises a flag, the work checks it between steps
+ * 			that leave nothing half done and stops there. Once the work starts
+ * 			changing what it cannot restore it commits, and is no longer
+ * 			cancelled
+ *
+ */
+
+class Progress
+{
+public:
+	Progress(const std::string&, const char* = "bytes");
+
+	Progress(const Progress&) = delete;
+	Progress& operator=(const Progress&) = delete;
+
+	void expect(std::uint64_t);
+	void advance(std::uint64_t);
+	bool cancel();
+	bool commit();
+	bool isCancelled() const;
+	const std::string& getTask() const;
+	std::string describe() const;
+
+private:
+	/**
+	 * @brief	Command the progress is of, as typed
+	 */
+
+	std::string task;
+
+	/**
+	 * @brief	What the work is counted in
+	 */
+
+	const char* unit;
+
+	/**
+	 * @brief	Amount of work done
+	 */
+
+	std::atomic<std::uint64_t> done;
+
+	/**
+	 * @brief	Amount of work expected, 0 if not known
+	 */
+
+	std::atomic<std::uint64_t> total;
+
+	/**
+	 * @enum	State
+	 *
+	 * @brief	Whether the work may still be cancelled
+	 */
+
+	enum State
+	{
+		Running,
+		Cancelled,
+		Committed
+	};
+
+	/**
+	 * @brief	State of the work, changed once from running
+	 */
+
+	std::atomic<State> state;
+
+	/**
+	 * @brief	When the work started
+	 */
+
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,516 @@
+#include "Server.h"
+#include "Console.h"
+#include "Stats.h"
+#include "StringUtils.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <istream>
+#include <optional>
+#include <streambuf>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+bool sendAll(int, const char*, std::size_t);
+bool isStaleSocket(const std::string&);
+
+/**
+ * Connections waiting to be accepted before new ones are refused
+ */
+
+const int MAX_PENDING_CONNECTIONS = 128;
+
+/**
+ * Size of the buffer commands are received into, in bytes
+ */
+
+const std::size_t RECEIVE_BUFFER_SIZE = 1 << 12;
+
+/**
+ * Output of a command held before part of it is sent, in bytes
+ */
+
+const std::size_t SEND_BUFFER_SIZE = 1 << 16;
+
+/**
+ * Byte ending every response
+ */
+
+const char END_OF_RESPONSE = '\0';
+
+/**
+ * @class	ConnectionBuffer
+ *
+ * @brief	Stream buffer over the connection of a client. Output is held until
+ * 			the response is complete, or large enough to send part of it, so a
+ * 			response takes as few writes as possible. Output is sent before
+ * 			blocking for input, so prompts reach the client in time
+ */
+
+class ConnectionBuffer : public std::streambuf
+{
+public:
+	/**
+	 * @brief				Constructs a buffer over a connected socket
+	 *
+	 * @param [in]	socket	Connected socket, not closed by the buffer
+	 *
+	 */
+
+	ConnectionBuffer(int socket) :socket(socket), broken(false) {
+		output.reserve(SEND_BUFFER_SIZE);
+	}
+
+	/**
+	 * @brief	Sends the output held followed by the end of the response
+	 *
+	 * @returns	True if the client received it, false if the connection is lost
+	 */
+
+	bool respond() {
+		output.push_back(END_OF_RESPONSE);
+		return send();
+	}
+
+protected:
+	int_type underflow() override {
+		if (!send())
+			return traits_type::eof();
+
+		ssize_t received;
+
+		do
+			received = recv(socket, input, sizeof(input), 0);
+		while (received < 0 && errno == EINTR);
+
+		if (received <= 0)
+			return traits_type::eof();
+
+		setg(input, input, input + received);
+		return traits_type::to_int_type(input[0]);
+	}
+
+	int_type overflow(int_type c) override {
+		if (traits_type::eq_int_type(c, traits_type::eof()))
+			return traits_type::not_eof(c);
+
+		output.push_back(traits_type::to_char_type(c));
+		return output.size() < SEND_BUFFER_SIZE || send() ? c : traits_type::eof();
+	}
+
+	std::streamsize xsputn(const char* data, std::streamsize count) override {
+		output.append(data, count);
+		return output.size() < SEND_BUFFER_SIZE || send() ? count : 0;
+	}
+
+private:
+	/**
+	 * @brief	Connected socket
+	 */
+
+	int socket;
+
+	/**
+	 * @brief	Set once sending fails, output is dropped from then on
+	 */
+
+	bool broken;
+
+	/**
+	 * @brief	Output not sent yet
+	 */
+
+	std::string output;
+
+	/**
+	 * @brief	Input received, not read yet
+	 */
+
+	char input[RECEIVE_BUFFER_SIZE];
+
+	/**
+	 * @brief	Sends the output held
+	 *
+	 * @returns	True if the client received it, false if the connection is lost
+	 */
+
+	bool send() {
+		broken = broken || !sendAll(socket, output.data(), output.size());
+		output.clear();
+		return !broken;
+	}
+};
+
+/**
+ * @brief					Constructs a server running commands on a manager
+ *
+ * @param [in]	manager		Manager running the commands
+ *
+ */
+
+Server::Server(TableManager& manager) :manager(manager), listener(-1), stopping(false) {
+}
+
+/**
+ * @brief	Destructor stopping the server and joining every session
+ *
+ */
+
+Server::~Server() {
+	stop();
+
+	std::list<Session> remaining;
+
+	{
+		std::lock_guard<std::mutex> guard(sessionsLock);
+		remaining.splice(remaining.end(), sessions);
+	}
+
+	for (Session& session : remaining)
+		session.thread.join();
+
+#ifndef _WIN32
+	if (listener >= 0)
+		::close(listener);
+#endif
+}
+
+/**
+ * @brief					Starts listening for clients
+ *
+ * @param [in]	endpoint	Port number to listen on at localhost, or path
+ * 							of the Unix domain socket to create
+ *
+ * @returns					True if listening, false if the endpoint cannot be used
+ */
+
+bool Server::listen(const std::string& endpoint) {
+#ifdef _WIN32
+	Console::out() << "Server mode is not available on Windows!" << std::endl;
+	return false;
+#else
+	std::optional<int> port = StringUtils::parseInteger(endpoint);
+	bool bound;
+
+	if (port.has_value()) {
+		if (port.value() <= 0 || port.value() > 65535) {
+			Console::out() << "Invalid port! (Hint: ports are 1 to 65535)" << std::endl;
+			return false;
+		}
+
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port.value());
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		int reuse = 1;
+		listener = socket(AF_INET, SOCK_STREAM, 0);
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		bound = bind(listener, (sockaddr*)&address, sizeof(address)) == 0;
+	}
+
+	else {
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+
+		if (endpoint.empty() || endpoint.size() >= sizeof(address.sun_path)) {
+			Console::out() << "Invalid socket path! (Hint: at most " << sizeof(address.sun_path) - 1 << " characters)" << std::endl;
+			return false;
+		}
+
+		std::memcpy(address.sun_path, endpoint.data(), endpoint.size());
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		bound = bind(listener, (sockaddr*)&address, sizeof(address)) == 0;
+
+		if (!bound && errno == EADDRINUSE && isStaleSocket(endpoint)) {
+			unlink(endpoint.c_str());
+			bound = bind(listener, (sockaddr*)&address, sizeof(address)) == 0;
+		}
+
+		if (bound)
+			socketPath = endpoint;
+	}
+
+	if (!bound || ::listen(listener, MAX_PENDING_CONNECTIONS) != 0) {
+		Console::out() << "Error listening on " << endpoint << "! (" << std::strerror(errno) << ")" << std::endl;
+		::close(listener);
+		listener = -1;
+
+		if (!socketPath.empty())
+			unlink(socketPath.c_str());
+
+		socketPath.clear();
+		return false;
+	}
+
+	Console::out() << "Serving on " << endpoint << "!" << std::endl;
+	return true;
+#endif
+}
+
+/**
+ * @brief	Accepts clients until stopped, serving each on a thread of its own.
+ * 			Sessions of clients that left are joined as new clients arrive
+ *
+ */
+
+void Server::run() {
+#ifndef _WIN32
+	while (!stopping) {
+		int connection = accept(listener, nullptr, nullptr);
+
+		if (connection < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			break;
+		}
+
+		if (socketPath.empty()) {
+			int noDelay = 1;
+			setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+		}
+
+		reap();
+
+		std::lock_guard<std::mutex> guard(sessionsLock);
+
+		if (stopping) {
+			::close(connection);
+			break;
+		}
+
+		Session& session = sessions.emplace_back();
+		session.connection = connection;
+		session.finished = false;
+		session.thread = std::thread(&Server::serve, this, std::ref(session));
+	}
+#endif
+}
+
+/**
+ * @brief	Stops accepting clients and disconnects those connected. Sessions
+ * 			finish the command they are running first
+ *
+ */
+
+void Server::stop() {
+#ifndef _WIN32
+	std::lock_guard<std::mutex> guard(sessionsLock);
+
+	if (stopping.exchange(true))
+		return;
+
+	if (listener >= 0)
+		shutdown(listener, SHUT_RDWR);
+
+	if (!socketPath.empty())
+		unlink(socketPath.c_str());
+
+	for (Session& session : sessions)
+		if (!session.finished)
+			shutdown(session.connection, SHUT_RDWR);
+#endif
+}
+
+/**
+ * @brief				Serves a client: reads its commands one line at a time and
+ * 						runs them with its connection bound as the console of the
+ * 						thread. Saves the client requested are reported along with
+ * 						the response to a later command. The exit command ends the
+ * 						session, not the server
+ *
+ * @param [in]	session	Session of the client
+ *
+ */
+
+void Server::serve(Session& session) {
+#ifndef _WIN32
+	ConnectionBuffer buffer(session.connection);
+	std::iostream stream(&buffer);
+	Console::Binding binding(stream, stream);
+
+	for (std::string command; std::getline(stream, command);) {
+		if (StringUtils::trim(std::string_view(command)) == "exit")
+			break;
+
+		execute(command);
+
+		if (manager.saver.hasReports())
+			stream << manager.saver.takeReports();
+
+		if (!buffer.respond())
+			break;
+	}
+
+	manager.saver.forget(stream);
+
+	std::lock_guard<std::mutex> guard(sessionsLock);
+	::close(session.connection);
+	session.finished = true;
+#endif
+}
+
+/**
+ * @brief				Runs a command, together with other reads if it only reads,
+ * 						alone otherwise. A print takes a version of the table under
+ * 						the shared lock, or under the exclusive one once pending
+ * 						formulas are evaluated if the table is not settled, and writes
+ * 						it out once the lock is released, so streaming a large table
+ * 						to a slow client holds off no edit.
+ * 						Sheets over the memory budget are evicted after every command
+ * 						run alone. Progress and cancel take no lock, so they reach a
+ * 						long command of another client while it runs
+ *
+ * @param [in]	command	User command
+ *
+ */
+
+void Server::execute(std::string& command) {
+	if (manager.isImmediate(command)) {
+		manager.runCommand(command);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> passing(turnstile);
+	}
+
+	std::shared_ptr<const Table> version;
+	bool printing = false;
+	auto start = std::chrono::steady_clock::now();
+
+	{
+		std::shared_lock<std::shared_mutex> reading(lock);
+
+		if (manager.isReadOnly(command)) {
+			if (StringUtils::trim(std::string_view(command)) != "print") {
+				manager.runCommand(command);
+				return;
+			}
+
+			printing = true;
+
+			if (manager.table != nullptr)
+				version = manager.table->version(false);
+		}
+	}
+
+	if (printing) {
+		if (version != nullptr)
+			version->render();
+
+		auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		Stats::record("print", latency.count());
+		return;
+	}
+
+	std::unique_lock<std::mutex> waiting(turnstile);
+	std::unique_lock<std::shared_mutex> writing(lock);
+	waiting.unlock();
+
+	if (StringUtils::trim(std::string_view(command)) != "print") {
+		manager.runCommand(command);
+		manager.workbook.trim();
+		return;
+	}
+
+	if (manager.table != nullptr) {
+		manager.table->settle();
+		version = manager.table->version(false);
+	}
+
+	manager.workbook.trim();
+	writing.unlock();
+
+	if (version != nullptr)
+		version->render();
+
+	auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	Stats::record("print", latency.count());
+}
+
+/**
+ * @brief	Joins the sessions of clients that left
+ *
+ */
+
+void Server::reap() {
+	std::lock_guard<std::mutex> guard(sessionsLock);
+
+	for (auto session = sessions.begin(); session != sessions.end();) {
+		if (!session->finished) {
+			++session;
+			continue;
+		}
+
+		session->thread.join();
+		session = sessions.erase(session);
+	}
+}
+
+/**
+ * @brief				Writes a whole buffer to a socket, retrying partial writes
+ *
+ * @param [in]	socket	Connected socket
+ *
+ * @param [in]	data	Bytes to write
+ *
+ * @param [in]	size	Number of bytes
+ *
+ * @returns				True if every byte was written, false if the connection is lost
+ */
+
+bool sendAll(int socket, const char* data, std::size_t size) {
+#ifdef _WIN32
+	return false;
+#else
+	while (size != 0) {
+		ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+
+		if (sent < 0 && errno == EINTR)
+			continue;
+
+		if (sent <= 0)
+			return false;
+
+		data += sent;
+		size -= sent;
+	}
+
+	return true;
+#endif
+}
+
+/**
+ * @brief				Checks if a Unix domain socket was left behind by a server
+ * 						no longer running, no server accepting connections on it
+ *
+ * @param [in]	path	Path of the socket
+ *
+ * @returns				True if nothing listens on the socket
+ */
+
+bool isStaleSocket(const std::string& path) {
+#ifdef _WIN32
+	return false;
+#else
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.data(), std::min(path.size(), sizeof(address.sun_path) - 1));
+
+	int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	bool stale = connect(probe, (sockaddr*)&address, sizeof(address)) != 0 && errno == ECONNREFUSED;
+	::close(probe);
+
+	return stale;
+#endif
+}
@@ -0,0 +1,110 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "TableManager.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @class	Server
+ *
+ * @brief	Serves the table of a manager to many clients at once over a Unix
+ * 			domain socket or a localhost TCP port. Clients send the commands of
+ * 			the console, one per line, and every response ends with a NUL byte.
+ * 			Each client is served on a thread of its own. Reads run together
+ * 			under a shared lock, every other command runs alone, so edits are
+ * 			serialized. A waiting edit holds back reads arriving after it, so
+ * 			a stream of prints never starves the edits. Prints write out a
+ * 			version of the table taken under the shared lock, after releasing
+ * 			it, so edits go on while the table is streamed to the clients
+ *
+ */
+
+class Server
+{
+public:
+	Server(TableManager&);
+	~Server();
+
+	Server(const Server&) = delete;
+	Server& operator=(const Server&) = delete;
+
+	bool listen(const std::string&);
+	void run();
+	void stop();
+
+private:
+	/**
+	 * @struct	Session
+	 *
+	 * @brief	Connection of a client and the thread serving it
+	 */
+
+	struct Session
+	{
+		int connection;
+		std::thread thread;
+		std::atomic<bool> finished;
+	};
+
+	/**
+	 * @brief	Manager running the commands
+	 */
+
+	TableManager& manager;
+
+	/**
+	 * @brief	Held shared by reads and exclusively by every other command
+	 */
+
+	std::shared_mutex lock;
+
+	/**
+	 * @brief	Held by a command waiting for the exclusive lock, and passed
+	 * 			through by reads, so reads arriving later wait behind it
+	 */
+
+	std::mutex turnstile;
+
+	/**
+	 * @brief	Socket accepting the clients, -1 while not listening
+	 */
+
+	int listener;
+
+	/**
+	 * @brief	Path of the Unix domain socket, removed once stopped,
+	 * 			empty for a TCP port
+	 */
+
+	std::string socketPath;
+
+	/**
+	 * @brief	Set once the server is stopped
+	 */
+
+	std::atomic<bool> stopping;
+
+	/**
+	 * @brief	Clients connected, and those that left but are not yet joined
+	 */
+
+	std::list<Session> sessions;
+
+	/**
+	 * @brief	Serializes changes to the sessions
+	 */
+
+	std::mutex sessionsLock;
+
+	void serve(Session&);
+	void execute(std::string&);
+	void reap();
+};
+
+#endif
@@ -0,0 +1,407 @@
+#include "Snapshot.h"
+#include "MappedFile.h"
+#include "StringUtils.h"
+#include "Stats.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+std::uint64_t alignSection(std::uint64_t);
+
+/**
+ * Magic bytes opening every snapshot file
+ */
+
+const char SNAPSHOT_MAGIC[4] = { 'E', 'T', 'B', '\0' };
+
+/**
+ * Version of the snapshot format written, texts are kept without quotation marks
+ */
+
+const std::uint32_t SNAPSHOT_VERSION = 2;
+
+/**
+ * Oldest version of the snapshot format read, texts kept with quotation marks
+ */
+
+const std::uint32_t QUOTED_TEXTS_VERSION = 1;
+
+/**
+ * Byte order mark, read back unchanged only on machines of the byte order it was written on
+ */
+
+const std::uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief					Writes a table as a binary snapshot. The stream should not
+ * 							write to a file the table is mapped from, snapshots are to
+ * 							be written to a temporary file renamed over the target
+ *
+ * @param [in]	table		Table to save
+ *
+ * @param [in,out]	output	Binary stream to write to
+ *
+ * @returns					True if the snapshot was written, false otherwise
+ */
+
+bool Snapshot::save(const Table& table, std::ostream& output) {
+	const CellStore& cells = table.cells;
+	Header header = {};
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.byteOrder = SNAPSHOT_BYTE_ORDER;
+	header.mode = (std::uint32_t)cells.mode;
+	header.rows = table.rows;
+	header.columns = table.columns;
+
+	const void* data[SectionCount] = {};
+	std::uint64_t bytes[SectionCount] = {};
+
+	std::vector<CellType> types;
+	std::vector<double> values;
+	std::vector<std::uint32_t> textIds;
+	std::vector<std::uint64_t> indices;
+
+	if (cells.mode == StorageMode::Dense) {
+		header.cellCount = cells.types.size();
+		header.textIdCount = cells.textIds.size();
+	}
+
+	else {
+		for (int i = 0; i < table.rows; ++i) {
+			for (int j = cells.skipEmpty(i, 0); j < table.columns; j = cells.skipEmpty(i, j + 1)) {
+				std::size_t index = (std::size_t)i * table.columns + j;
+
+				if (cells.type(index) == CellType::Empty)
+					continue;
+
+				types.push_back(cells.type(index));
+				values.push_back(cells.value(index));
+				textIds.push_back(cells.textId(index));
+				indices.push_back(index);
+			}
+		}
+
+		header.cellCount = indices.size();
+		header.textIdCount = textIds.size();
+		data[Types] = types.data();
+		data[Values] = values.data();
+		data[TextIds] = textIds.data();
+		data[Indices] = indices.data();
+		bytes[Indices] = indices.size() * sizeof(std::uint64_t);
+	}
+
+	bytes[Types] = header.cellCount * sizeof(CellType);
+	bytes[Values] = header.cellCount * sizeof(double);
+	bytes[TextIds] = header.textIdCount * sizeof(std::uint32_t);
+
+	std::vector<std::uint64_t> textOffsets = { 0 };
+
+	for (const std::string& text : cells.texts->texts)
+		textOffsets.push_back(textOffsets.back() + text.size());
+
+	header.textCount = cells.texts->texts.size();
+	header.freeTextCount = cells.texts->freeIds.size();
+	data[TextOffsets] = textOffsets.data();
+	bytes[TextOffsets] = textOffsets.size() * sizeof(std::uint64_t);
+	bytes[TextBlob] = textOffsets.back();
+	data[FreeTextIds] = cells.texts->freeIds.data();
+	bytes[FreeTextIds] = cells.texts->freeIds.size() * sizeof(std::uint32_t);
+
+	std::vector<std::size_t> formulaCells;
+	std::vector<FormulaRecord> records;
+	std::vector<Formula::Instruction> instructions;
+	std::string sources;
+
+	for (const auto& formula : *table.formulas)
+		formulaCells.push_back(formula.first);
+
+	std::sort(formulaCells.begin(), formulaCells.end());
+
+	for (std::size_t index : formulaCells) {
+		const Formula& formula = table.formulas->at(index);
+		records.push_back({ index, instructions.size(), sources.size(), (std::uint32_t)formula.program.size(), (std::uint32_t)formula.source.size() });
+		instructions.insert(instructions.end(), formula.program.begin(), formula.program.end());
+		sources.append(formula.source);
+	}
+
+	header.formulaCount = records.size();
+	header.instructionCount = instructions.size();
+	data[Formulas] = records.data();
+	bytes[Formulas] = records.size() * sizeof(FormulaRecord);
+	data[Instructions] = instructions.data();
+	bytes[Instructions] = instructions.size() * sizeof(Formula::Instruction);
+	data[Sources] = sources.data();
+	bytes[Sources] = sources.size();
+
+	std::uint64_t offset = alignSection(sizeof(Header));
+
+	for (int section = 0; section < SectionCount; ++section) {
+		header.sections[section] = offset;
+		offset = alignSection(offset + bytes[section]);
+	}
+
+	const char padding[8] = {};
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(padding, header.sections[0] - sizeof(header));
+
+	for (int section = 0; section < SectionCount; ++section) {
+		if (section == TextBlob) {
+			for (const std::string& text : cells.texts->texts)
+				output.write(text.data(), text.size());
+		}
+
+		else if (cells.mode == StorageMode::Dense && section == Types)
+			cells.types.write(output);
+
+		else if (cells.mode == StorageMode::Dense && section == Values)
+			cells.values.write(output);
+
+		else if (cells.mode == StorageMode::Dense && section == TextIds)
+			cells.textIds.write(output);
+
+		else if (bytes[section] > 0)
+			output.write(static_cast<const char*>(data[section]), bytes[section]);
+
+		output.write(padding, alignSection(bytes[section]) - bytes[section]);
+	}
+
+	Stats::add(Stats::BytesWritten, offset);
+	return output.good();
+}
+
+/**
+ * @brief					Opens a binary snapshot. The file is mapped copy-on-write
+ * 							and a dense store uses its cell sections in place, without
+ * 							copying them. The layout of the file is checked against its
+ * 							size, the type and text id of every cell against the texts,
+ * 							and the formula programs against the table. Every formula
+ * 							cell must come with its formula. The values are not read,
+ * 							so opening a dense store reads 5 bytes per cell at most
+ *
+ * @param [in]	file		Snapshot file
+ *
+ * @returns					Opened table, nullptr if the file is not a valid snapshot
+ */
+
+Table* Snapshot::open(const std::string& file) {
+	std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(file, true);
+
+	if (!mapping->isOpen() || mapping->size() < sizeof(Header))
+		return nullptr;
+
+	char* base = mapping->data();
+	std::uint64_t size = mapping->size();
+	Header header;
+	std::memcpy(&header, base, sizeof(header));
+
+	if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || (header.version != SNAPSHOT_VERSION && header.version != QUOTED_TEXTS_VERSION)
+		|| header.byteOrder != SNAPSHOT_BYTE_ORDER || header.mode > (std::uint32_t)StorageMode::Sparse
+		|| header.rows < 0 || header.columns < 0)
+		return nullptr;
+
+	auto fits = [&](Section section, std::uint64_t count, std::uint64_t elementSize) {
+		std::uint64_t offset = header.sections[section];
+		return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+	};
+
+	StorageMode mode = (StorageMode)header.mode;
+	std::uint64_t cellCount = (std::uint64_t)header.rows * header.columns;
+
+	if ((mode == StorageMode::Dense ? header.cellCount != cellCount : header.cellCount > cellCount)
+		|| (header.textIdCount != header.cellCount && (mode == StorageMode::Sparse || header.textIdCount != 0))
+		|| !fits(Types, header.cellCount, sizeof(CellType)) || !fits(Values, header.cellCount, sizeof(double))
+		|| !fits(TextIds, header.textIdCount, sizeof(std::uint32_t))
+		|| (mode == StorageMode::Sparse && !fits(Indices, header.cellCount, sizeof(std::uint64_t)))
+		|| header.textCount >= size || !fits(TextOffsets, header.textCount + 1, sizeof(std::uint64_t))
+		|| !fits(FreeTextIds, header.freeTextCount, sizeof(std::uint32_t))
+		|| !fits(Formulas, header.formulaCount, sizeof(FormulaRecord))
+		|| !fits(Instructions, header.instructionCount, sizeof(Formula::Instruction)))
+		return nullptr;
+
+	const std::uint64_t* textOffsets = reinterpret_cast<const std::uint64_t*>(base + header.sections[TextOffsets]);
+	const char* textBlob = base + header.sections[TextBlob];
+
+	if (textOffsets[0] != 0 || !fits(TextBlob, textOffsets[header.textCount], 1))
+		return nullptr;
+
+	std::unique_ptr<Table> table(new Table(mode == StorageMode::Dense ? 0 : header.rows, mode == StorageMode::Dense ? 0 : header.columns, mode));
+	CellStore& cells = table->cells;
+	table->rows = header.rows;
+	table->columns = header.columns;
+	TextPool& pool = cells.texts.write();
+	std::vector<std::string>& texts = pool.texts;
+	texts.clear();
+	texts.reserve(std::max<std::uint64_t>(header.textCount, 1));
+
+	for (std::uint64_t i = 0; i < header.textCount; ++i) {
+		if (textOffsets[i] > textOffsets[i + 1] || textOffsets[i + 1] > textOffsets[header.textCount])
+			return nullptr;
+
+		std::uint64_t length = textOffsets[i + 1] - textOffsets[i];
+
+		if (header.version == QUOTED_TEXTS_VERSION && length >= 2)
+			texts.emplace_back(textBlob + textOffsets[i] + 1, length - 2);
+		else
+			texts.emplace_back(textBlob + textOffsets[i], length);
+	}
+
+	if (texts.empty())
+		texts.emplace_back();
+
+	const std::uint32_t* freeTextIds = reinterpret_cast<const std::uint32_t*>(base + header.sections[FreeTextIds]);
+	pool.freeIds.assign(freeTextIds, freeTextIds + header.freeTextCount);
+
+	if (std::any_of(pool.freeIds.begin(), pool.freeIds.end(), [&](std::uint32_t id) { return id == 0 || id >= header.textCount; }))
+		return nullptr;
+
+	pool.rebuild();
+
+	CellType* types = reinterpret_cast<CellType*>(base + header.sections[Types]);
+	double* values = reinterpret_cast<double*>(base + header.sections[Values]);
+	std::uint32_t* textIds = reinterpret_cast<std::uint32_t*>(base + header.sections[TextIds]);
+
+	std::uint64_t textIdLimit = std::max<std::uint64_t>(header.textCount, 1);
+	std::vector<std::uint64_t> formulaCells;
+
+	if (mode == StorageMode::Dense) {
+		for (std::uint64_t i = 0; i < cellCount; ++i) {
+			std::uint32_t textId = header.textIdCount != 0 ? textIds[i] : 0;
+
+			if (types[i] > CellType::Formula || textId >= textIdLimit || (types[i] == CellType::Text) != (textId != 0))
+				return nullptr;
+
+			if (types[i] == CellType::Formula)
+				formulaCells.push_back(i);
+		}
+
+		cells.rows = header.rows;
+		cells.columns = header.columns;
+		cells.types.borrow(types, cellCount);
+		cells.values.borrow(values, cellCount);
+
+		if (header.textIdCount != 0)
+			cells.textIds.borrow(textIds, cellCount);
+
+		cells.snapshot = mapping;
+	}
+
+	else {
+		const std::uint64_t* indices = reinterpret_cast<const std::uint64_t*>(base + header.sections[Indices]);
+
+		for (std::uint64_t i = 0; i < header.cellCount; ++i) {
+			if (indices[i] >= cellCount || types[i] > CellType::Formula || textIds[i] >= textIdLimit
+				|| (types[i] == CellType::Text) != (textIds[i] != 0))
+				return nullptr;
+
+			if (types[i] == CellType::Formula)
+				formulaCells.push_back(indices[i]);
+
+			cells.assign(indices[i], types[i], values[i], textIds[i]);
+		}
+	}
+
+	const FormulaRecord* records = reinterpret_cast<const FormulaRecord*>(base + header.sections[Formulas]);
+	const Formula::Instruction* instructions = reinterpret_cast<const Formula::Instruction*>(base + header.sections[Instructions]);
+	const char* sources = base + header.sections[Sources];
+
+	for (std::uint64_t i = 0; i < header.formulaCount; ++i) {
+		const FormulaRecord& record = records[i];
+
+		if (record.index >= cellCount || record.firstInstruction > header.instructionCount
+			|| record.instructionCount > header.instructionCount - record.firstInstruction
+			|| record.sourceOffset > size || !fits(Sources, record.sourceOffset + record.sourceLength, 1)
+			|| (cells.type(record.index) != CellType::Formula && cells.type(record.index) != CellType::Error))
+			return nullptr;
+
+		Formula formula;
+		formula.source.assign(sources + record.sourceOffset, record.sourceLength);
+		formula.program.assign(instructions + record.firstInstruction, instructions + record.firstInstruction + record.instructionCount);
+
+		if (!isValidProgram(formula, cellCount))
+			return nullptr;
+
+		bool compile = std::any_of(formula.program.begin(), formula.program.end(), [](const Formula::Instruction& instruction) {
+			return instruction.code >= Formula::Instruction::Sum;
+		});
+
+		if (compile) {
+			if (!StringUtils::isFormula(formula.source))
+				return nullptr;
+
+			formula = Formula(formula.source, header.rows, header.columns);
+		}
+
+		else
+			for (const Formula::Instruction& instruction : formula.program)
+				if (instruction.code == Formula::Instruction::Reference)
+					formula.references.push_back(instruction.index);
+
+		table->linkFormula(record.index, std::move(formula));
+	}
+
+	for (std::uint64_t index : formulaCells)
+		if (table->formulas->count(index) == 0)
+			return nullptr;
+
+	return table.release();
+}
+
+/**
+ * @brief				Checks if a file is a binary snapshot by its extension
+ *
+ * @param [in]	file	File name
+ *
+ * @returns				True if the file is .etb, false otherwise
+ */
+
+bool Snapshot::isSnapshotFile(const std::string& file) {
+	return file.size() >= 4 && file.compare(file.size() - 4, 4, ".etb") == 0;
+}
+
+/**
+ * @brief					Checks that a formula program read from a snapshot only
+ * 							refers to cells of the table and keeps its stack in bounds.
+ * 							Ranges and references to other sheets are not stored, programs
+ * 							aggregating ranges or referring to other sheets are compiled
+ * 							again from their text
+ *
+ * @param [in]	formula		Formula to check
+ *
+ * @param [in]	cellCount	Number of cells of the table
+ *
+ * @returns					True if the program can be evaluated safely
+ */
+
+bool Snapshot::isValidProgram(const Formula& formula, std::size_t cellCount) {
+	int height = 0;
+
+	for (const Formula::Instruction& instruction : formula.program) {
+		if (instruction.code > Formula::Instruction::External)
+			return false;
+
+		if (instruction.code == Formula::Instruction::Constant || instruction.code == Formula::Instruction::Reference
+			|| instruction.code >= Formula::Instruction::Sum) {
+			if ((instruction.code == Formula::Instruction::Reference && instruction.index >= cellCount) || ++height > Formula::STACK_SIZE)
+				return false;
+		}
+
+		else if (--height < 1)
+			return false;
+	}
+
+	return height == 1;
+}
+
+/**
+ * @brief				Rounds a section offset or size up to a multiple of 8 bytes
+ *
+ * @param [in]	offset	Offset or size in bytes
+ *
+ * @returns				Aligned offset or size
+ */
+
+std::uint64_t alignSection(std::uint64_t offset) {
+	return (offset + 7) / 8 * 8;
+}
@@ -0,0 +1,93 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Table.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @class	Snapshot
+ *
+ * @brief	Binary snapshot format of a table (.etb). A snapshot keeps the
+ * 			cell store arrays as they are in memory, so opening one maps the
+ * 			file and points a dense store straight at its sections. Pages are
+ * 			read by the OS only when first touched and copied only when first
+ * 			written. Formulas are kept as their text and compiled program,
+ * 			texts, without quotation marks, as one blob indexed by text pool id
+ *
+ */
+
+class Snapshot
+{
+public:
+	static bool save(const Table&, std::ostream&);
+	static Table* open(const std::string&);
+	static bool isSnapshotFile(const std::string&);
+
+private:
+	/**
+	 * @brief	Sections of a snapshot file, each aligned to 8 bytes
+	 */
+
+	enum Section
+	{
+		Types,
+		Values,
+		TextIds,
+		Indices,
+		TextOffsets,
+		TextBlob,
+		FreeTextIds,
+		Formulas,
+		Instructions,
+		Sources,
+		SectionCount
+	};
+
+	/**
+	 * @struct	Header
+	 *
+	 * @brief	Header at the start of a snapshot file. Dense stores save every
+	 * 			cell in the Types, Values and, if the store has text ids, TextIds
+	 * 			sections. Sparse stores save only their non-empty cells there,
+	 * 			along with their absolute indices in the Indices section
+	 */
+
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+		std::uint32_t mode;
+		std::int32_t rows;
+		std::int32_t columns;
+		std::uint64_t cellCount;
+		std::uint64_t textIdCount;
+		std::uint64_t textCount;
+		std::uint64_t freeTextCount;
+		std::uint64_t formulaCount;
+		std::uint64_t instructionCount;
+		std::uint64_t sections[SectionCount];
+	};
+
+	/**
+	 * @struct	FormulaRecord
+	 *
+	 * @brief	Formula cell of a snapshot, its program and text given as ranges
+	 * 			of the Instructions and Sources sections
+	 */
+
+	struct FormulaRecord
+	{
+		std::uint64_t index;
+		std::uint64_t firstInstruction;
+		std::uint64_t sourceOffset;
+		std::uint32_t instructionCount;
+		std::uint32_t sourceLength;
+	};
+
+	static bool isValidProgram(const Formula&, std::size_t);
+};
+
+#endif
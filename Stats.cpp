@@ -0,0 +1,290 @@
+#include "Stats.h"
+#include "Console.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+std::uint64_t total(Stats::Counter);
+std::size_t bucketOf(std::uint64_t);
+std::uint64_t bucketLimit(std::size_t);
+std::string formatDuration(std::uint64_t);
+
+/**
+ * Sub-buckets per power of two of a latency histogram, each 1/8 of it wide
+ */
+
+const int SUB_BUCKETS = 8;
+
+/**
+ * Buckets of a latency histogram, enough for any 64-bit number of nanoseconds
+ */
+
+const std::size_t BUCKETS = 64 * SUB_BUCKETS;
+
+/**
+ * Commands timed, by name as typed
+ */
+
+const char* const COMMANDS[] = { "open", "edit", "batch", "value", "print", "save", "saveas", "compact" };
+
+/**
+ * Number of commands timed
+ */
+
+const std::size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+/**
+ * @struct	Histogram
+ *
+ * @brief	Latencies of a command in buckets growing with the latency,
+ * 			each bucket within 12.5% of the latencies it counts
+ */
+
+struct Histogram
+{
+	std::uint64_t buckets[BUCKETS] = {};
+	std::uint64_t count = 0;
+	std::uint64_t maximum = 0;
+};
+
+/**
+ * Counters of every thread that has counted anything, never freed, so the
+ * counts of threads that have exited are kept
+ */
+
+std::vector<std::unique_ptr<Stats::Slot>> slots;
+
+/**
+ * Serializes adding slots with reading them
+ */
+
+std::mutex slotsLock;
+
+/**
+ * Totals of the counters when last reset, subtracted from their totals
+ */
+
+std::uint64_t baseline[Stats::CounterCount] = {};
+
+/**
+ * Latency histograms of the commands timed
+ */
+
+Histogram histograms[COMMAND_COUNT];
+
+/**
+ * Serializes the clients of a server recording latencies with reading them
+ */
+
+std::mutex histogramsLock;
+
+/**
+ * True while counting and timing, cleared by the stats off command
+ */
+
+std::atomic<bool> Stats::enabled(true);
+
+/**
+ * @brief	Gives the counters of the calling thread, adding them to the
+ * 			slots read the first time the thread counts anything
+ *
+ * @returns	Counters of the calling thread
+ */
+
+Stats::Slot& Stats::localSlot() {
+	thread_local Slot* slot = []() {
+		std::lock_guard<std::mutex> guard(slotsLock);
+		slots.push_back(std::make_unique<Slot>());
+		return slots.back().get();
+	}();
+
+	return *slot;
+}
+
+/**
+ * @brief					Records the latency of a console command. Commands
+ * 							not timed are ignored
+ *
+ * @param [in]	command		Name of the command
+ *
+ * @param [in]	nanoseconds	Latency of the command
+ *
+ */
+
+void Stats::record(std::string_view command, std::uint64_t nanoseconds) {
+#ifndef NO_STATS
+	if (!enabled.load(std::memory_order_relaxed))
+		return;
+
+	for (std::size_t i = 0; i < COMMAND_COUNT; ++i) {
+		if (command != COMMANDS[i])
+			continue;
+
+		std::lock_guard<std::mutex> guard(histogramsLock);
+		Histogram& histogram = histograms[i];
+		++histogram.buckets[bucketOf(nanoseconds)];
+		++histogram.count;
+		histogram.maximum = std::max(histogram.maximum, nanoseconds);
+		return;
+	}
+#endif
+}
+
+/**
+ * @brief	Prints the counters and, for every command timed at least once,
+ * 			its number of runs and its median, 95th and 99th percentile and
+ * 			longest latencies
+ *
+ */
+
+void Stats::print() {
+#ifdef NO_STATS
+	Console::out() << "Statistics are not available! (Hint: build without NO_STATS)" << std::endl;
+#else
+	std::ostringstream output;
+
+	output << "Cells created:        " << total(NumberCells) << " numbers, " << total(TextCells) << " texts, "
+		<< total(FormulaCells) << " formulas, " << total(ErrorCells) << " errors, " << total(EmptyCells) << " empty\n"
+		<< "Formulas evaluated:   " << total(FormulasEvaluated) << "\n"
+		<< "References resolved:  " << total(ReferencesResolved) << "\n"
+		<< "Bytes written:        " << total(BytesWritten) << "\n"
+		<< std::left << std::setw(10) << "command" << std::right << std::setw(8) << "count"
+		<< std::setw(11) << "p50" << std::setw(11) << "p95" << std::setw(11) << "p99" << std::setw(11) << "max" << "\n";
+
+	std::unique_lock<std::mutex> guard(histogramsLock);
+
+	for (std::size_t i = 0; i < COMMAND_COUNT; ++i) {
+		const Histogram& histogram = histograms[i];
+
+		if (histogram.count == 0)
+			continue;
+
+		output << std::left << std::setw(10) << COMMANDS[i] << std::right << std::setw(8) << histogram.count;
+
+		for (double fraction : { 0.5, 0.95, 0.99 }) {
+			std::uint64_t rank = (std::uint64_t)(fraction * histogram.count + 0.999999), seen = 0;
+			std::size_t bucket = 0;
+
+			while ((seen += histogram.buckets[bucket]) < rank)
+				++bucket;
+
+			output << std::setw(11) << formatDuration(std::min(bucketLimit(bucket), histogram.maximum));
+		}
+
+		output << std::setw(11) << formatDuration(histogram.maximum) << "\n";
+	}
+
+	guard.unlock();
+
+	Console::out() << output.str();
+	Console::out().flush();
+
+	if (!enabled.load(std::memory_order_relaxed))
+		Console::out() << "Statistics are off! (Hint: type stats on to collect them)" << std::endl;
+#endif
+}
+
+/**
+ * @brief	Clears the counters and the latency histograms. Counters are
+ * 			only written by their threads, so their totals are recorded
+ * 			as the new baseline instead
+ *
+ */
+
+void Stats::reset() {
+	for (int counter = 0; counter < CounterCount; ++counter)
+		baseline[counter] += total((Counter)counter);
+
+	std::lock_guard<std::mutex> guard(histogramsLock);
+
+	for (Histogram& histogram : histograms)
+		histogram = Histogram();
+}
+
+/**
+ * @brief				Gives the total of a counter over every thread since
+ * 						the last reset
+ *
+ * @param [in]	counter	Counter to sum
+ *
+ * @returns				Total of the counter
+ */
+
+std::uint64_t total(Stats::Counter counter) {
+	std::lock_guard<std::mutex> guard(slotsLock);
+	std::uint64_t sum = 0;
+
+	for (const std::unique_ptr<Stats::Slot>& slot : slots)
+		sum += slot->counts[counter].load(std::memory_order_relaxed);
+
+	return sum - baseline[counter];
+}
+
+/**
+ * @brief					Gives the histogram bucket of a latency: latencies
+ * 							below 8 ns have a bucket each, then every power of
+ * 							two is split into 8 buckets by its next 3 bits
+ *
+ * @param [in]	nanoseconds	Latency
+ *
+ * @returns					Bucket of the latency
+ */
+
+std::size_t bucketOf(std::uint64_t nanoseconds) {
+	if (nanoseconds < SUB_BUCKETS)
+		return nanoseconds;
+
+	int exponent = 0;
+
+	while ((nanoseconds >> exponent) >= 2 * SUB_BUCKETS)
+		++exponent;
+
+	return (exponent + 1) * SUB_BUCKETS + (nanoseconds >> exponent) - SUB_BUCKETS;
+}
+
+/**
+ * @brief				Gives the longest latency of a histogram bucket
+ *
+ * @param [in]	bucket	Histogram bucket
+ *
+ * @returns				Longest latency in nanoseconds counted in the bucket
+ */
+
+std::uint64_t bucketLimit(std::size_t bucket) {
+	if (bucket < SUB_BUCKETS)
+		return bucket;
+
+	int exponent = bucket / SUB_BUCKETS - 1;
+	std::uint64_t mantissa = bucket % SUB_BUCKETS + SUB_BUCKETS;
+
+	return ((mantissa + 1) << exponent) - 1;
+}
+
+/**
+ * @brief					Gives a latency as text with 3 significant digits
+ * 							and the largest unit it is at least one of
+ *
+ * @param [in]	nanoseconds	Latency
+ *
+ * @returns					Formatted latency
+ */
+
+std::string formatDuration(std::uint64_t nanoseconds) {
+	const char* units[] = { "ns", "us", "ms", "s" };
+	double value = (double)nanoseconds;
+	int unit = 0;
+
+	while (unit < 3 && value >= 1000.) {
+		value /= 1000.;
+		++unit;
+	}
+
+	std::ostringstream output;
+	output << std::setprecision(3) << value << " " << units[unit];
+	return output.str();
+}
@@ -0,0 +1,79 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @namespace	Stats
+ *
+ * @brief		Counters of the work done on the hot paths and latency histograms
+ * 				of the console commands, printed by the stats command. Counters are
+ * 				kept per thread and summed when read, so threads evaluating formulas
+ * 				together never write to the same memory. Defining NO_STATS compiles
+ * 				all of it out, disabling it at run time leaves one test per count
+ */
+
+namespace Stats
+{
+	/**
+	 * @enum	Counter
+	 *
+	 * @brief	Quantity counted. Cells created are counted by type, in the
+	 * 			order of CellType
+	 */
+
+	enum Counter
+	{
+		EmptyCells,
+		NumberCells,
+		TextCells,
+		ErrorCells,
+		FormulaCells,
+		FormulasEvaluated,
+		ReferencesResolved,
+		BytesWritten,
+		CounterCount
+	};
+
+	/**
+	 * @struct	Slot
+	 *
+	 * @brief	Counters of a single thread, written by that thread only
+	 */
+
+	struct Slot
+	{
+		std::atomic<std::uint64_t> counts[CounterCount] = {};
+	};
+
+	extern std::atomic<bool> enabled;
+
+	Slot& localSlot();
+	void record(std::string_view, std::uint64_t);
+	void print();
+	void reset();
+
+	/**
+	 * @brief				Adds to a counter of the calling thread. Only the thread
+	 * 						writes its slot, so the add needs no atomic instruction
+	 *
+	 * @param [in]	counter	Counter to add to
+	 *
+	 * @param [in]	amount	Amount to add
+	 *
+	 */
+
+	inline void add(Counter counter, std::uint64_t amount = 1) {
+#ifndef NO_STATS
+		if (!enabled.load(std::memory_order_relaxed))
+			return;
+
+		std::atomic<std::uint64_t>& count = localSlot().counts[counter];
+		count.store(count.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+#endif
+	}
+};
+
+#endif
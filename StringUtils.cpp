@@ -1,162 +1,441 @@
-#include "StringUtils.h"
-#include <regex>
-
-using namespace std::regex_constants;
-
-/**
- * @brief			 Check if a character is a sign, either '+' or '-'
- *
- * @param [in]	ch	 Character to check
- *
- * @returns			 True if the given character is a sign, false otherwise
- *
- */
-
-bool StringUtils::isSign(char ch)
-{
-	return ch == '+' || ch == '-';
-}
-
-/**
- * @brief			 Check if character is a digit
- *
- * @param [in]	ch	 Character to check
- *
- * @returns			 True if the given character is a digit, false otherwise
- *
- */
-
-
-bool StringUtils::isDigit(char ch) {
-	return ch >= '0' && ch <= '9';
-}
-
-/**
- * @brief			 Check if character is arithemtic operator (+, - , *, / and ^)
- *
- * @param [in]	ch	 Character to check
- *
- * @returns			 True if the given character is operator, false otherwise
- *
- */
-
-bool StringUtils::isMathOperator(char ch) {
-	return ch == '+' || ch == '-' || ch == '*' || ch == '/' || ch == '^';
-}
-
-/**
- * @brief				 Trims in-place the given string removing all leading and trailing whitespace characters.
- * 						 Whitespace characters are denoted by isspace() standart function and include
- *						 space, form feed, line feed, carriage return, horizontal tab and vertical tab
- *
- * @param [in,out]	str	 String to be trimmed
- *
- */
-
-void StringUtils::trim(std::string& str) {
-	if (str.empty())
-		return;
-
-	std::string spaceChars = " \t\f\v\n\r";
-
-	std::size_t pos1 = str.find_first_not_of(spaceChars);
-	std::size_t pos2 = str.std::string::find_last_not_of(spaceChars);
-
-	if (pos1 != std::string::npos && pos2 != std::string::npos)
-		str = str.substr(pos1, pos2 - pos1 + 1);
-}
-
-/**
- * @brief			 Check if string represents an integer. Note that '+' or '-'
- * 					 sign are allowed in the beginning of the integer
- *
- * @param [in]	str	 String to check
- *
- * @returns			 True if the given string represents an integer
- *
- */
-
-bool StringUtils::isInteger(const std::string& str) {
-	const std::regex regexInteger("(\\+|-)?[0-9]+", ECMAScript);
-	return std::regex_match(str, regexInteger);
-}
-
-/**
- * @brief			 Check if string represents a number. Note that '+' or '-'
- * 					 sign are allowed in the beginning of the integer along with
- * 					 floating point in the middle of the number
- *
- * @param [in]	str	 String to check
- *
- * @returns			 True if the given string represents a number, else otherwise
- *
- */
-
-bool StringUtils::isNumber(const std::string& str) {
-	const std::regex regexNumber("(\\+|-)?[0-9]+[.]?[0-9]*", ECMAScript);
-	return std::regex_match(str, regexNumber);
-}
-
-/**
- * @brief			 Check if string represents a cell reference of type
- * 					 'R<row>C<col>'
- *
- * @param [in]	str	 String to check
- *
- * @returns			 True if the given string represents a reference, else otherwise
- *
- */
-
-bool StringUtils::isCellReference(const std::string& str) {
-	const std::regex regexCellReference("R[1-9][0-9]*C[1-9][0-9]*", ECMAScript);
-	return std::regex_match(str, regexCellReference);
-}
-
-/**
- * @brief			 Check if string represents a table formula. Should begin with '=' and
- * 					 contains only cell references, numbers and mathematical operators
- *
- * @param [in]	str	 String to check
- *
- * @returns			 True if the given string represents a formula, else otherwise
- *
- */
-
-bool StringUtils::isFormula(const std::string& str) {
-
-	if (str.size() < 2 || str.front() != '=' || !isDigit(str.back()))
-		return false;
-
-	int pos = 1;
-
-	for (int i = 1; i < str.size(); ++i) {
-
-		char ch = str.at(i);
-
-		if (isMathOperator(ch) || i == str.size() - 1) {
-			int includeLastSymbol = (i == str.size() - 1) ? 1 : 0;
-			std::string temp = str.substr(pos, i - pos + includeLastSymbol);
-
-			if (temp.empty() || isSign(temp.front()) || !(isNumber(temp) || isCellReference(temp)))
-				return false;
-
-			pos = i + 1;
-		}
-	}
-
-	return true;
-}
-
-/**
- * @brief			 Check if string represents a quoted text ""
- *
- * @param [in]	str	 String to check
- *
- * @returns			 True if the given string represents a quoted text,
- * 					 else otherwise
- *
- */
-
-bool StringUtils::isQuotedText(const std::string& str) {
-	return str.size() > 1 && str.front() == '"' && str.back() == '"';
-}
+#include "StringUtils.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+bool isSpace(char);
+std::size_t scanDigits(std::string_view, std::size_t);
+
+/**
+ * Longest fixed notation of a double with three decimals: 309 integer
+ * digits, sign, point and decimals
+ */
+
+const int MAX_NUMBER_LENGTH = 320;
+
+/**
+ * @brief			 Check if a character is a sign, either '+' or '-'
+ *
+ * @param [in]	ch	 Character to check
+ *
+ * @returns			 True if the given character is a sign, false otherwise
+ *
+ */
+
+bool StringUtils::isSign(char ch)
+{
+	return ch == '+' || ch == '-';
+}
+
+/**
+ * @brief			 Check if character is a digit
+ *
+ * @param [in]	ch	 Character to check
+ *
+ * @returns			 True if the given character is a digit, false otherwise
+ *
+ */
+
+
+bool StringUtils::isDigit(char ch) {
+	return ch >= '0' && ch <= '9';
+}
+
+/**
+ * @brief			 Check if character is arithemtic operator (+, - , *, / and ^)
+ *
+ * @param [in]	ch	 Character to check
+ *
+ * @returns			 True if the given character is operator, false otherwise
+ *
+ */
+
+bool StringUtils::isMathOperator(char ch) {
+	return ch == '+' || ch == '-' || ch == '*' || ch == '/' || ch == '^';
+}
+
+/**
+ * @brief			 Check if character is a whitespace character as denoted by isspace()
+ * 					 standart function: space, form feed, line feed, carriage return,
+ * 					 horizontal tab and vertical tab
+ *
+ * @param [in]	ch	 Character to check
+ *
+ * @returns			 True if the given character is whitespace, false otherwise
+ *
+ */
+
+bool isSpace(char ch) {
+	return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+/**
+ * @brief				 Trims in-place the given string removing all leading and trailing whitespace characters.
+ * 						 Whitespace characters are denoted by isspace() standart function and include
+ *						 space, form feed, line feed, carriage return, horizontal tab and vertical tab
+ *
+ * @param [in,out]	str	 String to be trimmed
+ *
+ */
+
+void StringUtils::trim(std::string& str) {
+	std::string_view trimmed = trim(std::string_view(str));
+
+	str.erase(trimmed.data() - str.data() + trimmed.size());
+	str.erase(0, trimmed.data() - str.data());
+}
+
+/**
+ * @brief			 Gives a view of the given string without its leading and trailing
+ * 					 whitespace characters. No characters are copied
+ *
+ * @param [in]	str	 String to be trimmed
+ *
+ * @returns			 Trimmed view, empty if the string holds only whitespace
+ *
+ */
+
+std::string_view StringUtils::trim(std::string_view str) {
+	std::size_t begin = 0, end = str.size();
+
+	while (begin < end && isSpace(str[begin]))
+		++begin;
+
+	while (end > begin && isSpace(str[end - 1]))
+		--end;
+
+	return str.substr(begin, end - begin);
+}
+
+/**
+ * @brief				Gives the position of the first non-digit character
+ * 						at or after given position
+ *
+ * @param [in]	str		String to scan
+ *
+ * @param [in]	pos		Position to start from
+ *
+ * @returns				Position of the first non-digit, or the string size
+ *
+ */
+
+std::size_t scanDigits(std::string_view str, std::size_t pos) {
+	while (pos < str.size() && StringUtils::isDigit(str[pos]))
+		++pos;
+
+	return pos;
+}
+
+/**
+ * @brief			 Parses a number in a single pass. Note that '+' or '-' sign are
+ * 					 allowed in the beginning of the number along with floating point
+ * 					 in the middle of the number
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The number, or empty value if the string does not represent one
+ *
+ */
+
+std::optional<double> StringUtils::parseNumber(std::string_view str) {
+	std::size_t begin = (!str.empty() && str.front() == '+') ? 1 : 0;
+	std::size_t digits = (begin == 0 && !str.empty() && str.front() == '-') ? 1 : begin;
+	std::size_t pos = scanDigits(str, digits);
+
+	if (pos == digits)
+		return std::nullopt;
+
+	if (pos < str.size() && str[pos] == '.')
+		pos = scanDigits(str, pos + 1);
+
+	if (pos != str.size())
+		return std::nullopt;
+
+	double value;
+	std::from_chars_result result = std::from_chars(str.data() + begin, str.data() + str.size(), value);
+
+	if (result.ec != std::errc() || result.ptr != str.data() + str.size())
+		return std::nullopt;
+
+	return value;
+}
+
+/**
+ * @brief			 Parses an integer in a single pass. Note that '+' or '-'
+ * 					 sign are allowed in the beginning of the integer
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The integer, or empty value if the string does not represent
+ * 					 one or it is out of range
+ *
+ */
+
+std::optional<int> StringUtils::parseInteger(std::string_view str) {
+	std::size_t begin = (!str.empty() && str.front() == '+') ? 1 : 0;
+	std::size_t digits = (begin == 0 && !str.empty() && str.front() == '-') ? 1 : begin;
+
+	if (digits == str.size() || scanDigits(str, digits) != str.size())
+		return std::nullopt;
+
+	int value;
+	std::from_chars_result result = std::from_chars(str.data() + begin, str.data() + str.size(), value);
+
+	if (result.ec != std::errc())
+		return std::nullopt;
+
+	return value;
+}
+
+/**
+ * @brief			 Parses a cell reference of type 'R<row>C<col>' in a single pass
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The referenced row and column, or empty value if the string does
+ * 					 not represent a reference or it is out of range
+ *
+ */
+
+std::optional<std::pair<int, int>> StringUtils::parseCellReference(std::string_view str) {
+	if (str.size() < 4 || str.front() != 'R' || str[1] == '0')
+		return std::nullopt;
+
+	std::size_t posColumn = scanDigits(str, 1);
+
+	if (posColumn == 1 || posColumn + 1 >= str.size() || str[posColumn] != 'C' || str[posColumn + 1] == '0'
+		|| scanDigits(str, posColumn + 1) != str.size())
+		return std::nullopt;
+
+	int row, col;
+	std::from_chars_result rowResult = std::from_chars(str.data() + 1, str.data() + posColumn, row);
+	std::from_chars_result colResult = std::from_chars(str.data() + posColumn + 1, str.data() + str.size(), col);
+
+	if (rowResult.ec != std::errc() || colResult.ec != std::errc())
+		return std::nullopt;
+
+	return std::make_pair(row, col);
+}
+
+/**
+ * @brief			 Parses a range of cells of type 'R<row>C<col>:R<row>C<col>',
+ * 					 given by two opposite corners in any order
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The first and the last row and column of the range, or empty
+ * 					 value if the string does not represent a range
+ *
+ */
+
+std::optional<std::pair<std::pair<int, int>, std::pair<int, int>>> StringUtils::parseCellRange(std::string_view str) {
+	std::size_t separator = str.find(':');
+
+	if (separator == std::string_view::npos)
+		return std::nullopt;
+
+	std::optional<std::pair<int, int>> first = parseCellReference(str.substr(0, separator));
+	std::optional<std::pair<int, int>> last = parseCellReference(str.substr(separator + 1));
+
+	if (!first.has_value() || !last.has_value())
+		return std::nullopt;
+
+	return std::make_pair(std::make_pair(std::min(first->first, last->first), std::min(first->second, last->second)),
+		std::make_pair(std::max(first->first, last->first), std::max(first->second, last->second)));
+}
+
+/**
+ * @brief			 Check if string represents an integer. Note that '+' or '-'
+ * 					 sign are allowed in the beginning of the integer
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents an integer
+ *
+ */
+
+bool StringUtils::isInteger(std::string_view str) {
+	return parseInteger(str).has_value();
+}
+
+/**
+ * @brief			 Check if string represents a number. Note that '+' or '-'
+ * 					 sign are allowed in the beginning of the integer along with
+ * 					 floating point in the middle of the number
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents a number, else otherwise
+ *
+ */
+
+bool StringUtils::isNumber(std::string_view str) {
+	return parseNumber(str).has_value();
+}
+
+/**
+ * @brief			 Check if string represents a cell reference of type
+ * 					 'R<row>C<col>'
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents a reference, else otherwise
+ *
+ */
+
+bool StringUtils::isCellReference(std::string_view str) {
+	return parseCellReference(str).has_value();
+}
+
+/**
+ * @brief			 Parses a reference to a cell of another sheet of type
+ * 					 '<sheet>!R<row>C<col>'
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The sheet name and the referenced row and column, or empty
+ * 					 value if the string does not represent such a reference
+ *
+ */
+
+std::optional<std::pair<std::string_view, std::pair<int, int>>> StringUtils::parseSheetReference(std::string_view str) {
+	std::size_t separator = str.find('!');
+
+	if (separator == std::string_view::npos || !isSheetName(str.substr(0, separator)))
+		return std::nullopt;
+
+	std::optional<std::pair<int, int>> cell = parseCellReference(str.substr(separator + 1));
+
+	if (!cell.has_value())
+		return std::nullopt;
+
+	return std::make_pair(str.substr(0, separator), cell.value());
+}
+
+/**
+ * @brief			 Check if string represents a reference to a cell of
+ * 					 another sheet of type '<sheet>!R<row>C<col>'
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents such a reference, false otherwise
+ *
+ */
+
+bool StringUtils::isSheetReference(std::string_view str) {
+	return parseSheetReference(str).has_value();
+}
+
+/**
+ * @brief			 Check if string is a valid sheet name: a non-empty run of
+ * 					 letters, digits and underscores, as the name of the file
+ * 					 holding the sheet without its extension
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string is a sheet name, false otherwise
+ *
+ */
+
+bool StringUtils::isSheetName(std::string_view str) {
+	return !str.empty() && std::all_of(str.begin(), str.end(), [](char ch) {
+		return isDigit(ch) || ch == '_' || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+	});
+}
+
+/**
+ * @brief			 Check if string represents an aggregate of a range of cells, one of
+ * 					 SUM, AVG, MIN, MAX or COUNT applied to a range, as in SUM(R1C1:R10C1)
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents an aggregate, false otherwise
+ *
+ */
+
+bool StringUtils::isAggregate(std::string_view str) {
+	std::size_t open = str.find('(');
+
+	if (open == std::string_view::npos || str.back() != ')')
+		return false;
+
+	std::string_view name = str.substr(0, open);
+
+	return (name == "SUM" || name == "AVG" || name == "MIN" || name == "MAX" || name == "COUNT")
+		&& parseCellRange(str.substr(open + 1, str.size() - open - 2)).has_value();
+}
+
+/**
+ * @brief			 Check if string represents a table formula. Should begin with '=' and
+ * 					 contains only cell references, references to cells of other sheets,
+ * 					 aggregates of ranges, numbers and mathematical operators
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents a formula, else otherwise
+ *
+ */
+
+bool StringUtils::isFormula(std::string_view str) {
+
+	if (str.size() < 2 || str.front() != '=' || !(isDigit(str.back()) || str.back() == ')'))
+		return false;
+
+	std::size_t pos = 1;
+
+	for (std::size_t i = 1; i <= str.size(); ++i) {
+		if (i < str.size() && !isMathOperator(str[i]))
+			continue;
+
+		std::string_view operand = str.substr(pos, i - pos);
+
+		if (operand.empty() || isSign(operand.front()) || !(isNumber(operand) || isCellReference(operand) || isSheetReference(operand) || isAggregate(operand)))
+			return false;
+
+		pos = i + 1;
+	}
+
+	return true;
+}
+
+/**
+ * @brief			 Check if string represents a quoted text ""
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the given string represents a quoted text,
+ * 					 else otherwise
+ *
+ */
+
+bool StringUtils::isQuotedText(std::string_view str) {
+	return str.size() > 1 && str.front() == '"' && str.back() == '"';
+}
+
+/**
+ * @brief			  Gives the string representation of a number, with
+ * 					  precision of 3 digits after the floating point, if
+ * 					  present. Any trailing zeros are not being printed
+ *
+ * @param [in]	value  Number to format
+ *
+ * @returns			  String representation of the number
+ *
+ */
+
+std::string StringUtils::formatNumber(double value) {
+	if (std::fabs(value - std::round(value)) < 0.001)
+		return std::to_string((int)std::round(value));
+
+	int x = std::round(1000 * value), precision = 1;
+
+	if (x % 100 != 0) {
+		++precision;
+		if (x % 10 != 0)
+			++precision;
+	}
+
+	char buffer[MAX_NUMBER_LENGTH];
+	std::to_chars_result result = std::to_chars(buffer, buffer + MAX_NUMBER_LENGTH, value, std::chars_format::fixed, precision);
+	return std::string(buffer, result.ptr);
+}
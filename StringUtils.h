@@ -1,27 +1,40 @@
-#ifndef STRING_UTILS_H
-#define STRING_UTILS_H
-
-#include <string>
-
-/**
- * @namespace	StringUtils
- *
- * @brief		Contains some useful methods for string and char manipulation
- * 				and data type asserting
- */
-
-namespace StringUtils
-{
-	bool isDigit(char);
-	bool isMathOperator(char);
-	bool isSign(char);
-	void trim(std::string&);
-	bool isNumber(const std::string&);
-	bool isInteger(const std::string&);
-	bool isFormula(const std::string&);
-	bool isCellReference(const std::string&);
-	bool isQuotedText(const std::string&);
-};
-
-#endif
-
+#ifndef STRING_UTILS_H
+#define STRING_UTILS_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * @namespace	StringUtils
+ *
+ * @brief		Contains some useful methods for string and char manipulation
+ * 				and data type asserting
+ */
+
+namespace StringUtils
+{
+	bool isDigit(char);
+	bool isMathOperator(char);
+	bool isSign(char);
+	void trim(std::string&);
+	std::string_view trim(std::string_view);
+	std::optional<double> parseNumber(std::string_view);
+	std::optional<int> parseInteger(std::string_view);
+	std::optional<std::pair<int, int>> parseCellReference(std::string_view);
+	std::optional<std::pair<std::pair<int, int>, std::pair<int, int>>> parseCellRange(std::string_view);
+	std::optional<std::pair<std::string_view, std::pair<int, int>>> parseSheetReference(std::string_view);
+	bool isNumber(std::string_view);
+	bool isInteger(std::string_view);
+	bool isFormula(std::string_view);
+	bool isCellReference(std::string_view);
+	bool isSheetReference(std::string_view);
+	bool isSheetName(std::string_view);
+	bool isAggregate(std::string_view);
+	bool isQuotedText(std::string_view);
+	std::string formatNumber(double);
+};
+
+#endif
+
@@ -1,360 +1,1569 @@
-#include "Table.h" 
-#include "NumCell.h" 
-#include "TextCell.h"
-#include "EmptyCell.h"
-#include "ErrorCell.h"
-#include "StringUtils.h"
-#include <iostream>
-#include <iomanip>
-#include <stack>
-#include <cmath>
-#include <cassert>
-
-void printKSpaces(int k);
-
-/**
- * @brief				  Constructs a table with empty cells from
- * 						  given number of rows and columns
- *
- * @param [in]	rows   	  Number of rows
- *
- * @param [in]	columns	  Number of columns
- */
-
-Table::Table(int rows, int columns) : rows(rows), columns(columns) {
-	table = new Cell * [rows * columns];
-
-	for (int i = 0; i < rows * columns; ++i)
-		table[i] = new EmptyCell();
-}
-
-/**
- * @brief	Destructs the object deallocting dynamic memory
- *
- */
-
-Table::~Table() {
-	for (int i = 0; i < rows * columns; ++i)
-		delete table[i];
-}
-
-/**
- * @brief								Static factory method that creates a cell from given value.
- * 										If the cell is a number, a number cell is created
- * 										If the cell is a string, a text cell is created
- * 										If the cell is either a reference or a formula, it is
- * 										evaluated and the new value is assigned to the cell
- * 										If evaluation fails or the type is unknown, an error cell is produced
- *
- * @param [in,out]	str					Desired cell value
- *
- * @param [in] 		supressMessages		If set to true (false by default), no messages will be printed out,
- * 										apart from evalatuion errors (ex. dividing by zero)
- *
- * @returns								Cell from the evaluated type, or
- * 										ErrorCell if evaluation fails
- */
-
-Cell* Table::createCell(std::string& str, bool supressMessages) {
-	StringUtils::trim(str);
-
-	std::string msg = "Error in cell! Cell has invalid type! Error cell is produced!";
-
-	if (str.empty())
-		return new EmptyCell();
-
-	else if (StringUtils::isQuotedText(str))
-		return new TextCell(str);
-
-	else if (StringUtils::isNumber(str))
-		return new NumCell(std::stod(str));
-
-	else if (StringUtils::isFormula(str)) {
-		std::optional<double> result = calculateFormula(str);
-		if (result.has_value())
-			return new NumCell(result.value());
-		else
-			msg = "Error in cell! Dividing by zero is not allowed! Error cell is produced!";
-	}
-
-	if (!supressMessages)
-		std::cout << msg << std::endl;
-
-	return new ErrorCell();
-}
-
-/**
- * @brief			Evaluate reference to a floating value,
- * 					0 by default
- *
- * @param 	ref		The reference to be evaluated
- *
- * @returns			Floating result of evaluation, 0 if fails
- */
-
-double Table::evaluateReference(const std::string& ref) const {
-	size_t posColumn = ref.find_first_of("C");
-
-	if (posColumn != std::string::npos) {
-		std::string row = ref.substr(1, posColumn - 1);
-		std::string col = ref.substr(posColumn + 1);
-		int x = std::stoi(row), y = std::stoi(col);
-
-		if (cellExists(x, y))
-			return table[getIndexCell(x - 1, y - 1)]->evaluate();
-	}
-
-	return 0.;
-}
-
-/**
- * @brief			  Gives precedence value of a mathematical operator as follows:
- * 					  '^' is valued 4, '*' and '/' - 3 and '+' or '-' - 2
- *
- * @param [in]	 ch	  Character that is mathematical operator
- *
- * @returns			  Operator precedence value
- *
- * @throws			  Assertion error if given character is not an operator
- */
-
-int precedence(const char& ch) {
-	return (ch == '*' || ch == '/') ? 3 : (ch == '^') ? 4 : 2;
-}
-
-/**
- * @brief					Executes the next operation defined by the last operator
- * 							and the last two recorded operands
- *
- * @param [in,out]	nums	Number stack
- *
- * @param [in,out]	ops 	Operator stack
- *
- * @returns					True if it succeeds, false if it fails.
- */
-
-bool doNextOperation(std::stack<double>& nums, std::stack<char>& ops) {
-	char op = ops.top(); ops.pop();
-	double y = nums.top(); nums.pop();
-	double x = nums.top(); nums.pop();
-
-	if (op == '/' && fabs(y - .0) < 0.001)
-		return false;
-
-	double result = (op == '+') ? (x + y) : (op == '-') ? (x - y) : (op == '*') ? (x * y) : (op == '/') ? (x / y) : pow(x, y);
-	nums.push(result);
-
-	return true;
-}
-
-/**
- * @brief		 Evaluates a given infix-notated formula using Shunting-yard algorithm
- * 				 in linear O(n) time and space complexity. If evaluation fails, it returns
- * 				 an empty value
- *
- * @param 	str	 The string.
- *
- * @returns		 The floating result of the expression on success, or empty value otherwise
- */
-
-std::optional<double> Table::calculateFormula(const std::string& str) const {
-	std::stack<double> nums;
-	std::stack<char> ops;
-
-	size_t i = 0, j = 0, pos = 1;
-
-	for (i = 1; i < str.size(); ++i) {
-
-		char ch = str.at(i);
-
-		if (StringUtils::isMathOperator(ch)) {
-			std::string temp = str.substr(pos, str.size() - pos - 1);
-			if (temp.front() == 'R')
-				nums.push(evaluateReference(temp));
-			else
-				nums.push(std::stod(temp));
-
-			pos = i + 1;
-
-			while (!ops.empty() && precedence(ops.top()) >= precedence(ch))
-				if (!doNextOperation(nums, ops)) {
-					return std::nullopt;
-				}
-
-			ops.push(ch);
-		}
-
-		else if (i == str.size() - 1) {
-			std::string temp = str.substr(pos, str.size() - pos);
-			if (temp.front() == 'R')
-				nums.push(evaluateReference(temp));
-			else
-				nums.push(std::stod(temp));
-
-			while (!ops.empty() && precedence(ops.top()) >= precedence(ch))
-				if (!doNextOperation(nums, ops))
-					return std::nullopt;
-		}
-	}
-
-	return nums.top();
-}
-
-/**
- * @brief				Check if given cell is in table range
- *
- * @param [in]	row		The cell' row
- *
- * @param [in] 	col		The cell' column
- *
- * @returns				True if cell is valid, false if out of range
- */
-
-bool Table::cellExists(int row, int col) const {
-	return row > 0 && col > 0 && row <= rows && col <= columns;
-}
-
-/**
- * @brief							Edit the value of given cell
- *
- * @param [in]	row					The cell' row
- *
- * @param [in] 	col					The cell' column
- *
- * @param [in] 	str					New cell value
- *
- * @param [in] 	supressMessages		If set to true (false by default), no messages will be printed out,
- * 									apart from evalatuion errors (ex. dividing by zero)
- *
- */
-
-void Table::editCell(int row, int col, std::string& str, bool supressMessages) {
-	std::string msg = "Invalid cell! Editing unsuccesful";
-
-	if (cellExists(row, col)) {
-		int indexCell = getIndexCell(row - 1, col - 1);
-		delete  table[indexCell];
-		table[indexCell] = nullptr;
-		table[indexCell] = createCell(str, supressMessages);
-
-		msg = "Cell edited succesfully!";
-	}
-
-	if (!supressMessages)
-		std::cout << msg << std::endl;
-}
-
-/**
- * @brief	Prints the table in format that every column is the same width
- * 			aligned according to the longest cell present there. Cell values
- * 			are enclosed by '|' symbol.
- *
- */
-
-void Table::print() const {
-	int* columnWidths = new int[columns];
-	for (int i = 0; i < columns; ++i)
-		columnWidths[i] = 0;
-
-	calculateColumnWidths(columnWidths);
-
-	for (size_t i = 0; i < rows; ++i) {
-		for (size_t j = 0; j < columns; ++j) {
-			std::string str = table[getIndexCell(i, j)]->toString();
-
-			int spaces = columnWidths[j] - str.size();
-
-			std::cout << "| ";
-			printKSpaces(spaces);
-
-			if (StringUtils::isQuotedText(str))
-				std::cout << str.substr(1, str.size() - 2);
-			else
-				std::cout << str;
-
-			std::cout << " ";
-
-			if (j == columns - 1)
-				std::cout << "|" << std::endl;
-		}
-	}
-}
-
-/**
- * @brief	               Stream insertion operator for Table objects
- *
- * @param [in,out]   os	   The output stream
- *
- * @param [in] 	     t     Table to be streamed
- *
- * @returns	               The streamed table object
- *
- */
-
-std::ostream& operator<<(std::ostream& os, const Table& t) {
-	char delimeter = ',';
-
-	for (size_t i = 0; i < t.rows; ++i) {
-		for (size_t j = 0; j < t.columns; ++j)
-			os << t.table[t.columns * i + j]->toString() << delimeter;
-		os << '\n';
-	}
-
-	return os;
-}
-
-/**
- * @brief		Gets cell absolute index from
- * 				given row and column
- *
- * @param 	x	cell row
- *
- * @param 	y	cell column
- *
- * @returns		Absolute index of cell
- */
-
-int Table::getIndexCell(int x, int y) const {
-	return x * columns + y;
-}
-
-/**
- * @brief							Calculates the table column widths according to
- * 									the longest string value encounntered
- *
- * @param [in,out]	columnWidths	Array of table column widths
- *
- */
-
-void Table::calculateColumnWidths(int* columnWidths) const {
-	for (size_t i = 0; i < rows; ++i) {
-		for (size_t j = 0; j < columns; ++j) {
-
-			std::string str = table[getIndexCell(i, j)]->toString();
-			size_t curentCellSize = str.size();
-
-			if (StringUtils::isQuotedText(str))
-				curentCellSize -= 2;
-
-			if (curentCellSize > columnWidths[j]) {
-				columnWidths[j] = curentCellSize;
-			}
-		}
-	}
-}
-
-/**
- * @brief			Print k spaces, no result if k is
- * 					non-positive
-
- * @param [in]	k	Number of spaces to print
- */
-
-void printKSpaces(int k) {
-	for (int i = 0; i < k; ++i)
-		std::cout << " ";
-}
-
-
-
-
+#include "Table.h" 
+#include "StringUtils.h"
+#include "ThreadPool.h"
+#include "Aggregate.h"
+#include "Stats.h"
+#include "Workbook.h"
+#include "Console.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+bool isValidValue(std::string_view);
+void appendCell(std::string&, std::string_view, std::size_t);
+void writeOutput(const std::string&);
+
+/**
+ * Recalculations of fewer cells than this are evaluated serially
+ */
+
+const std::size_t PARALLEL_THRESHOLD = 4096;
+
+/**
+ * Dependency levels of fewer cells than this are evaluated serially
+ */
+
+const std::size_t PARALLEL_LEVEL_SIZE = 256;
+
+/**
+ * Levels of the segment trees of ranges a position of Table::nextDependent can
+ * refer to, more than the levels of any tree over the rows of a table
+ */
+
+const std::size_t RANGE_LEVELS = 64;
+
+/**
+ * Tables of more cells than this are printed without keeping the frame
+ */
+
+const std::size_t FRAME_CACHE_CELLS = 1 << 22;
+
+/**
+ * Size in bytes at which output of a table saved, or printed without
+ * keeping the frame, is written out
+ */
+
+const std::size_t OUTPUT_CHUNK_SIZE = 1 << 20;
+
+/**
+ * @brief				  Constructs a table with empty cells from
+ * 						  given number of rows and columns
+ *
+ * @param [in]	rows   	  Number of rows
+ *
+ * @param [in]	columns	  Number of columns
+ *
+ * @param [in]	mode	  Cell storage layout, dense by default
+ */
+
+Table::Table(int rows, int columns, StorageMode mode) : rows(rows), columns(columns), cells(rows, columns, mode),
+	evaluation(EvaluationMode::Eager), pending(rows, columns), workbook(nullptr), revision(0), refreshing(false), frameValid(false) {
+}
+
+/**
+ * @brief				Copies a table along with its formulas and the formula
+ * 						cells left to evaluate, into memory of its own. The printed
+ * 						frame is not copied, it is rendered again if needed. The copy
+ * 						refers to the same sheets of the same workbook
+ *
+ * @param [in]	other	Table to copy
+ *
+ */
+
+Table::Table(const Table& other) : rows(other.rows), columns(other.columns), cells(other.cells),
+	formulas(other.formulas), dependents(other.dependents), rangeDependents(other.rangeDependents),
+	evaluation(other.evaluation), pending(other.pending), externalSheets(other.externalSheets), workbook(other.workbook),
+	revision(other.revision), refreshing(false), frameValid(false) {
+	cells.unshare();
+	formulas.write();
+}
+
+/**
+ * @brief								Factory method that assigns a cell from given value.
+ * 										If the cell is a number, a number cell is created
+ * 										If the cell is a string, a text cell is created
+ * 										If the cell is either a reference or a formula, the formula
+ * 										is kept in the table and its result is assigned to the cell
+ * 										If evaluation fails or the type is unknown, an error cell is produced.
+ * 										All formula cells depending on the cell are recalculated, or
+ * 										marked pending in lazy mode. A formula cell is evaluated
+ * 										right away in lazy mode as well, unless messages are supressed
+ *
+ * @param [in]		index				Absolute index of the cell
+ *
+ * @param [in]		str					Desired cell value
+ *
+ * @param [in] 		supressMessages		If set to true (false by default), no messages will be printed out,
+ * 										apart from evalatuion errors (ex. dividing by zero)
+ *
+ */
+
+void Table::createCell(std::size_t index, std::string_view str, bool supressMessages) {
+	assignCell(index, str, supressMessages);
+	propagate(std::vector<std::size_t>{ index });
+
+	if (supressMessages || !formulas->count(index))
+		return;
+
+	evaluatePending(index);
+
+	if (cells.type(index) == CellType::Error)
+		Console::error() << "Error in cell! Dividing by zero or circular reference is not allowed! Error cell is produced!" << std::endl;
+}
+
+/**
+ * @brief								Assigns a cell from given value without evaluating any formula.
+ * 										Formulas are compiled and linked to the dependency graph only
+ *
+ * @param [in]		index				Absolute index of the cell
+ *
+ * @param [in]		str					Desired cell value
+ *
+ * @param [in] 		supressMessages		If set to true, no messages will be printed out
+ *
+ */
+
+void Table::assignCell(std::size_t index, std::string_view str, bool supressMessages) {
+	str = StringUtils::trim(str);
+	unlinkFormula(index);
+
+	std::optional<double> number;
+
+	if (str.empty())
+		cells.setEmpty(index);
+
+	else if (StringUtils::isQuotedText(str))
+		cells.setText(index, str.substr(1, str.size() - 2));
+
+	else if ((number = StringUtils::parseNumber(str)).has_value())
+		cells.setNumber(index, number.value());
+
+	else if (StringUtils::isFormula(str))
+		linkFormula(index, Formula(str, rows, columns));
+
+	else {
+		if (!supressMessages)
+			Console::error() << "Error in cell! Cell has invalid type! Error cell is produced!" << std::endl;
+
+		cells.setError(index);
+	}
+
+	Stats::add((Stats::Counter)cells.type(index));
+	refreshCell(index);
+}
+
+/**
+ * @brief				Assigns a cell from given value without printing messages and
+ * 						without evaluating formulas. Meant for bulk loading, which
+ * 						should be completed by a single call to recalculate()
+ *
+ * @param [in]	row		The cell' row
+ *
+ * @param [in] 	col		The cell' column
+ *
+ * @param [in] 	str		New cell value
+ *
+ */
+
+void Table::setCell(int row, int col, std::string_view str) {
+	if (cellExists(row, col))
+		assignCell(getIndexCell(row - 1, col - 1), str, true);
+}
+
+/**
+ * @brief					Applies a batch of edits as one transaction. Every edit is
+ * 							checked first, and if any of them targets a cell out of range
+ * 							or holds a value of unknown type, none is applied. Otherwise
+ * 							the cells are assigned in order, so a later edit of the same
+ * 							cell wins, and the formulas affected by any of them are
+ * 							recalculated in a single pass. No messages are printed
+ *
+ * @param [in]	edits		Edits to apply
+ *
+ * @returns					Position of the first invalid edit, nothing if all were applied
+ */
+
+std::optional<std::size_t> Table::applyEdits(const std::vector<CellEdit>& edits) {
+	for (std::size_t i = 0; i < edits.size(); ++i)
+		if (!cellExists(edits[i].row, edits[i].col) || !isValidValue(edits[i].value))
+			return i;
+
+	setCells(edits);
+	return std::nullopt;
+}
+
+/**
+ * @brief					Assigns cells in order the way editCell does, values of unknown
+ * 							type included, skipping edits of cells out of range. Formulas
+ * 							affected by any of the edits are recalculated in a single pass,
+ * 							or marked pending in lazy mode, and no messages are printed
+ *
+ * @param [in]	edits		Edits to assign
+ *
+ */
+
+void Table::setCells(const std::vector<CellEdit>& edits) {
+	std::vector<std::size_t> origins;
+	origins.reserve(edits.size());
+
+	for (const CellEdit& edit : edits) {
+		if (!cellExists(edit.row, edit.col))
+			continue;
+
+		origins.push_back(getIndexCell(edit.row - 1, edit.col - 1));
+		assignCell(origins.back(), edit.value, true);
+	}
+
+	propagate(origins);
+}
+
+/**
+ * @brief					Changes the table dimensions and its cell storage layout. Cells
+ * 							out of the new dimensions are dropped. If the dimensions change,
+ * 							every formula is compiled again against them and recalculated
+ *
+ * @param [in]	newRows		New number of rows
+ *
+ * @param [in]	newColumns	New number of columns
+ *
+ * @param [in]	mode		New cell storage layout
+ *
+ */
+
+void Table::resize(int newRows, int newColumns, StorageMode mode) {
+	struct Source
+	{
+		int row, col;
+		std::string text;
+	};
+
+	std::vector<Source> sources;
+
+	if (newRows != rows || newColumns != columns) {
+		for (const auto& formula : *formulas)
+			sources.push_back({ (int)(formula.first / columns), (int)(formula.first % columns), formula.second.source });
+
+		formulas = {};
+		dependents.clear();
+		rangeDependents.clear();
+		externalSheets.clear();
+		pending.reset(newRows, newColumns);
+	}
+
+	++revision;
+	invalidateFrame();
+	cells.reshape(newRows, newColumns, mode);
+	rows = newRows;
+	columns = newColumns;
+
+	for (const Source& source : sources)
+		if (source.row < rows && source.col < columns)
+			linkFormula(getIndexCell(source.row, source.col), Formula(source.text, rows, columns));
+
+	if (!sources.empty())
+		recalculate();
+}
+
+/**
+ * @brief						Moves the cells of another table into consecutive rows of this
+ * 								one. The target rows should be empty and the source should not
+ * 								be wider than this table. Formulas of the source are not moved
+ *
+ * @param [in,out]	source		Table to move the cells from
+ *
+ * @param [in]		firstRow	Row of this table receiving the first source row
+ *
+ */
+
+void Table::moveRows(Table& source, int firstRow) {
+	invalidateFrame();
+	cells.moveRows(source.cells, firstRow - 1);
+}
+
+/**
+ * @brief	Gives the number of table rows
+ *
+ * @returns	Number of rows
+ */
+
+int Table::getRows() const {
+	return rows;
+}
+
+/**
+ * @brief	Gives the number of table columns
+ *
+ * @returns	Number of columns
+ */
+
+int Table::getColumns() const {
+	return columns;
+}
+
+/**
+ * @brief	Checks if printing the table or reading its cells changes nothing,
+ * 			so several threads may do it together: no formula is pending, none
+ * 			refers to another sheet and the frame is kept, unless the table is
+ * 			too large for one
+ *
+ * @returns	True if reads leave the table as it is
+ */
+
+bool Table::isSettled() const {
+	return pending.size() == 0 && externalSheets.empty() && (frameValid || (std::size_t)rows * columns > FRAME_CACHE_CELLS);
+}
+
+/**
+ * @brief						Takes a version of the table: a copy sharing the pages of
+ * 								its cells, its formulas and its frame, which the table copies
+ * 								on its next change while the version holds them. Taking one
+ * 								costs time in the number of pages, not of cells, so a version
+ * 								is taken while edits are held off and printed or saved while
+ * 								they go on. Versions keep no dependency graph and no pending
+ * 								cells, they are only read
+ *
+ * @param [in]	withFormulas	True to share the formulas, needed to save the version
+ * 								but not to print it. Without them an edit following a
+ * 								print does not copy every formula
+ *
+ * @returns						The version, freed along with the pages only it holds
+ * 								once its last reader drops it
+ */
+
+std::shared_ptr<const Table> Table::version(bool withFormulas) const {
+	std::shared_ptr<Table> version = std::make_shared<Table>(0, 0, cells.getMode());
+	version->rows = rows;
+	version->columns = columns;
+	version->cells = CellStore(cells);
+
+	if (withFormulas)
+		version->formulas = formulas;
+
+	version->evaluation = evaluation;
+	version->workbook = workbook;
+	version->revision = revision;
+	version->frame = CellArray<char>(frame);
+	version->frameValid = frameValid;
+
+	return version;
+}
+
+/**
+ * @brief	Gives an estimate of the memory held by the table in bytes,
+ * 			its cells, formulas and dependency graph
+ *
+ * @returns	Number of bytes allocated
+ */
+
+std::size_t Table::memoryUsage() const {
+	std::size_t bytes = cells.memoryUsage() + frame.capacity() + displayWidths.capacity() * sizeof(std::uint32_t);
+
+	for (const auto& formula : *formulas)
+		bytes += sizeof(formula) + formula.second.source.capacity() + formula.second.program.capacity() * sizeof(Formula::Instruction)
+			+ formula.second.references.capacity() * sizeof(std::size_t);
+
+	for (const auto& edges : dependents)
+		bytes += sizeof(edges) + edges.second.capacity() * sizeof(std::size_t);
+
+	for (const auto& edges : rangeDependents)
+		bytes += sizeof(edges) + edges.second.capacity() * sizeof(std::size_t);
+
+	return bytes;
+}
+
+/**
+ * @brief			 Runs the postfix program of a compiled formula on a fixed-size
+ * 					 stack. Runs in linear O(n) time with no allocation. If evaluation
+ * 					 fails (ex. dividing by zero, or referring to a sheet that is not
+ * 					 loaded), it returns an empty value
+ *
+ * @param 	formula	 The formula
+ *
+ * @returns			 The floating result of the expression on success, or empty value otherwise
+ */
+
+std::optional<double> Table::calculateFormula(const Formula& formula) const {
+	double stack[Formula::STACK_SIZE];
+	int top = 0;
+
+	for (const Formula::Instruction& instruction : formula.program) {
+		switch (instruction.code) {
+		case Formula::Instruction::Constant:
+			stack[top++] = instruction.value;
+			continue;
+		case Formula::Instruction::Reference:
+			stack[top++] = cells.value(instruction.index);
+			continue;
+		case Formula::Instruction::External: {
+			const Formula::External& external = formula.externals[instruction.index];
+			const Sheet* sheet = externalSheets[external.slot].sheet;
+
+			if (sheet == nullptr || sheet->table == nullptr)
+				return std::nullopt;
+
+			const Table& table = *sheet->table;
+			stack[top++] = table.cellExists(external.row, external.col) ? table.cells.value(table.getIndexCell(external.row - 1, external.col - 1)) : 0.;
+			continue;
+		}
+		case Formula::Instruction::Sum:
+		case Formula::Instruction::Average:
+		case Formula::Instruction::Minimum:
+		case Formula::Instruction::Maximum:
+		case Formula::Instruction::Count: {
+			std::optional<double> result = calculateAggregate(instruction.code, formula.ranges[instruction.index]);
+
+			if (!result.has_value())
+				return std::nullopt;
+
+			stack[top++] = result.value();
+			continue;
+		}
+		default:
+			break;
+		}
+
+		double y = stack[--top];
+		double& x = stack[top - 1];
+
+		switch (instruction.code) {
+		case Formula::Instruction::Add:
+			x += y;
+			break;
+		case Formula::Instruction::Subtract:
+			x -= y;
+			break;
+		case Formula::Instruction::Multiply:
+			x *= y;
+			break;
+		case Formula::Instruction::Divide:
+			if (std::fabs(y) < 0.001)
+				return std::nullopt;
+			x /= y;
+			break;
+		default:
+			x = std::pow(x, y);
+		}
+	}
+
+	return stack[0];
+}
+
+/**
+ * @brief			 Aggregates the number and formula cells of a range. Other cells
+ * 					 are skipped. Minimum and maximum of a range without such cells
+ * 					 are 0, their average fails as dividing by zero would
+ *
+ * @param [in]	code	Aggregate instruction
+ *
+ * @param [in]	range	Range of cells
+ *
+ * @returns			 The aggregate on success, or empty value otherwise
+ */
+
+std::optional<double> Table::calculateAggregate(Formula::Instruction::Code code, const Formula::Range& range) const {
+	Aggregate::Totals totals;
+	cells.aggregate(range.firstRow, range.firstColumn, range.lastRow, range.lastColumn, totals);
+
+	switch (code) {
+	case Formula::Instruction::Sum:
+		return totals.sum;
+	case Formula::Instruction::Average:
+		if (totals.count == 0)
+			return std::nullopt;
+		return totals.sum / totals.count;
+	case Formula::Instruction::Minimum:
+		return totals.count == 0 ? 0. : totals.minimum;
+	case Formula::Instruction::Maximum:
+		return totals.count == 0 ? 0. : totals.maximum;
+	default:
+		return (double)totals.count;
+	}
+}
+
+/**
+ * @brief					Stores the formula of a formula cell and adds the cell
+ * 							to the dependents of every cell the formula refers to,
+ * 							of every column its ranges span and of every other sheet
+ * 							it refers to. The cell is tagged
+ * 							as a formula cell right away, so that evaluating it later
+ * 							only overwrites its value
+ *
+ * @param [in]	index		Absolute index of the formula cell
+ *
+ * @param [in]	formula		Compiled formula
+ *
+ */
+
+void Table::linkFormula(std::size_t index, Formula&& formula) {
+	std::sort(formula.references.begin(), formula.references.end());
+	formula.references.erase(std::unique(formula.references.begin(), formula.references.end()), formula.references.end());
+
+	for (std::size_t reference : formula.references)
+		dependents[reference].push_back(index);
+
+	for (const Formula::Range& range : formula.ranges) {
+		for (std::uint64_t key : rangeKeys(range))
+			rangeDependents[key].push_back(index);
+
+		cells.retainIndices(range.firstRow, range.firstColumn, range.lastRow, range.lastColumn);
+	}
+
+	for (Formula::External& external : formula.externals) {
+		auto sheet = std::find_if(externalSheets.begin(), externalSheets.end(), [&](const ExternalSheet& sheet) {
+			return sheet.name == external.sheet;
+		});
+
+		if (sheet == externalSheets.end())
+			sheet = externalSheets.insert(sheet, { external.sheet, nullptr, 0, 0, {} });
+
+		external.slot = sheet - externalSheets.begin();
+
+		if (sheet->formulas.empty() || sheet->formulas.back() != index)
+			sheet->formulas.push_back(index);
+	}
+
+	std::unordered_map<std::size_t, Formula>& linked = formulas.write();
+	linked.erase(index);
+	linked.emplace(index, std::move(formula));
+
+	if (cells.type(index) != CellType::Formula && cells.type(index) != CellType::Error)
+		cells.setFormula(index, 0.);
+}
+
+/**
+ * @brief				Removes the formula of a cell, if present, along with
+ * 						its edges in the dependency graph
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ */
+
+void Table::unlinkFormula(std::size_t index) {
+	auto formula = formulas->find(index);
+
+	if (formula == formulas->end())
+		return;
+
+	for (std::size_t reference : formula->second.references) {
+		std::vector<std::size_t>& edges = dependents[reference];
+		edges.erase(std::find(edges.begin(), edges.end(), index));
+
+		if (edges.empty())
+			dependents.erase(reference);
+	}
+
+	for (const Formula::Range& range : formula->second.ranges) {
+		for (std::uint64_t key : rangeKeys(range)) {
+			std::vector<std::size_t>& edges = rangeDependents[key];
+			edges.erase(std::find(edges.begin(), edges.end(), index));
+
+			if (edges.empty())
+				rangeDependents.erase(key);
+		}
+
+		cells.releaseIndices(range.firstRow, range.firstColumn, range.lastRow, range.lastColumn);
+	}
+
+	for (const Formula::External& external : formula->second.externals) {
+		std::vector<std::size_t>& edges = externalSheets[external.slot].formulas;
+		auto edge = std::find(edges.begin(), edges.end(), index);
+
+		if (edge != edges.end())
+			edges.erase(edge);
+	}
+
+	formulas.write().erase(index);
+	pending.erase(index);
+}
+
+/**
+ * @brief				Evaluates the formula of a formula cell and assigns
+ * 						the result, or an error if evaluation fails
+ *
+ * @param [in]	index	Absolute index of the formula cell
+ *
+ */
+
+void Table::evaluateFormula(std::size_t index) {
+	const Formula& formula = formulas->at(index);
+	std::optional<double> result = calculateFormula(formula);
+
+	Stats::add(Stats::FormulasEvaluated);
+	Stats::add(Stats::ReferencesResolved, formula.references.size() + formula.externals.size());
+
+	if (result.has_value())
+		cells.setFormula(index, result.value());
+	else
+		cells.setError(index);
+
+	refreshCell(index);
+}
+
+/**
+ * @brief	Recalculates every formula cell of the table, or marks them
+ * 			all pending in lazy mode
+ *
+ */
+
+void Table::recalculate() {
+	refreshExternals();
+	++revision;
+
+	if (evaluation == EvaluationMode::Lazy) {
+		for (const auto& formula : *formulas)
+			pending.insert(formula.first);
+
+		return;
+	}
+
+	std::vector<std::size_t> origins;
+	origins.reserve(formulas->size());
+
+	for (const auto& formula : *formulas)
+		origins.push_back(formula.first);
+
+	recalculate(origins);
+}
+
+/**
+ * @brief				Reserves room for the formulas of a table being loaded,
+ * 						so linking them does not grow the dependency graph
+ *
+ * @param [in]	count	Number of formula cells expected
+ *
+ */
+
+void Table::reserveFormulas(std::size_t count) {
+	formulas.write().reserve(count);
+	dependents.reserve(count);
+}
+
+/**
+ * @brief	Evaluates every pending formula cell. Cells downstream of a pending
+ * 			cell are pending themselves, so recalculating from the pending cells
+ * 			evaluates exactly them, in dependency order and concurrently if many.
+ * 			References to other sheets are brought up to date first
+ *
+ */
+
+void Table::evaluate() {
+	refreshExternals();
+
+	if (pending.size() == 0)
+		return;
+
+	std::vector<std::size_t> origins;
+	origins.reserve(pending.size());
+
+	for (const auto& formula : *formulas)
+		if (pending.contains(formula.first))
+			origins.push_back(formula.first);
+
+	pending.clear();
+	recalculate(origins);
+}
+
+/**
+ * @brief				Sets when formula cells are evaluated. Switching to eager
+ * 						mode evaluates every pending formula cell
+ *
+ * @param [in]	mode	New evaluation mode
+ *
+ */
+
+void Table::setEvaluationMode(EvaluationMode mode) {
+	if (mode == EvaluationMode::Eager)
+		evaluate();
+	else if (evaluation == EvaluationMode::Eager)
+		pending.reset(rows, columns);
+
+	evaluation = mode;
+}
+
+/**
+ * @brief				Gives the value of a cell as printed, evaluating it
+ * 						first if it is a pending formula cell
+ *
+ * @param [in]	row		The cell' row
+ *
+ * @param [in] 	col		The cell' column
+ *
+ * @returns				Display string of the cell, nothing if out of range
+ */
+
+std::optional<std::string> Table::getValue(int row, int col) {
+	if (!cellExists(row, col))
+		return std::nullopt;
+
+	std::size_t index = getIndexCell(row - 1, col - 1);
+	refreshExternals();
+	evaluatePending(index);
+
+	std::string buffer;
+	return std::string(displayString(index, buffer));
+}
+
+/**
+ * @brief					Sets the workbook the sheets referred to by formulas
+ * 							are looked up in
+ *
+ * @param [in]	workbook	Workbook of the table, nullptr for none
+ *
+ */
+
+void Table::setWorkbook(Workbook* workbook) {
+	this->workbook = workbook;
+
+	for (ExternalSheet& external : externalSheets)
+		external.sheet = nullptr;
+}
+
+/**
+ * @brief					Brings the formula cells downstream of changed cells up to
+ * 							date. Eager tables recalculate them, lazy tables mark them
+ * 							pending, the changed cells themselves included if they are
+ * 							formulas. The walk stops at cells pending already, as every
+ * 							cell downstream of them is pending too. References to other
+ * 							sheets are brought up to date first, so the sheets are loaded
+ *
+ * @param [in]	origins		Absolute indices of the changed cells
+ *
+ */
+
+void Table::propagate(const std::vector<std::size_t>& origins) {
+	refreshExternals();
+	++revision;
+
+	if (evaluation == EvaluationMode::Eager) {
+		recalculate(origins);
+		return;
+	}
+
+	std::vector<std::size_t> stack;
+
+	for (std::size_t origin : origins)
+		if (!formulas->count(origin) || pending.insert(origin))
+			stack.push_back(origin);
+
+	while (!stack.empty()) {
+		std::size_t node = stack.back(), position = 0, dependent;
+		stack.pop_back();
+
+		while (nextDependent(node, position, dependent))
+			if (pending.insert(dependent))
+				stack.push_back(dependent);
+	}
+}
+
+/**
+ * @brief	Brings the formula cells referring to other sheets up to date. Every
+ * 			sheet referred to is looked up once, loaded if needed and brought up
+ * 			to date itself. Formulas referring to a sheet changed or loaded again
+ * 			since they were last evaluated are recalculated, or marked pending in
+ * 			lazy mode. Sheets referring to each other see each other as they are
+ *
+ */
+
+void Table::refreshExternals() {
+	if (externalSheets.empty() || workbook == nullptr || refreshing)
+		return;
+
+	refreshing = true;
+	std::vector<std::size_t> origins;
+
+	for (ExternalSheet& external : externalSheets) {
+		if (external.formulas.empty())
+			continue;
+
+		if (external.sheet == nullptr)
+			external.sheet = workbook->find(external.name);
+
+		const Table* table = workbook->acquire(*external.sheet);
+		std::uint64_t changes = table == nullptr ? 0 : table->revision;
+
+		if (external.generation == external.sheet->generation && external.revision == changes)
+			continue;
+
+		external.generation = external.sheet->generation;
+		external.revision = changes;
+		origins.insert(origins.end(), external.formulas.begin(), external.formulas.end());
+	}
+
+	if (!origins.empty())
+		propagate(origins);
+
+	refreshing = false;
+}
+
+/**
+ * @brief				Evaluates a pending formula cell along with the pending cells
+ * 						it depends on, and nothing else. The pending part of the graph
+ * 						upstream of the cell is split into strongly connected components
+ * 						by an iterative Tarjan search along the inputs of every cell,
+ * 						which completes each component after all of its inputs. Each is
+ * 						evaluated as it completes, components forming a cycle are turned
+ * 						into error cells, just as recalculation would
+ *
+ * @param [in]	index	Absolute index of the cell
+ *
+ */
+
+void Table::evaluatePending(std::size_t index) {
+	if (!pending.contains(index))
+		return;
+
+	struct Visit
+	{
+		int order, low;
+		bool onStack;
+	};
+
+	struct Call
+	{
+		std::size_t node;
+		std::vector<std::size_t> inputs;
+		std::size_t position;
+	};
+
+	std::unordered_map<std::size_t, Visit> visits;
+	std::vector<Call> calls;
+	std::vector<std::size_t> path;
+	int counter = 0;
+
+	auto enter = [&](std::size_t node) {
+		visits[node] = { counter, counter, true };
+		++counter;
+		path.push_back(node);
+		calls.push_back({ node, pendingInputs(node), 0 });
+	};
+
+	enter(index);
+
+	while (!calls.empty()) {
+		Call& call = calls.back();
+
+		if (call.position < call.inputs.size()) {
+			std::size_t node = call.node, next = call.inputs[call.position++];
+			auto visit = visits.find(next);
+
+			if (visit == visits.end())
+				enter(next);
+			else if (visit->second.onStack)
+				visits[node].low = std::min(visits[node].low, visit->second.order);
+
+			continue;
+		}
+
+		std::size_t node = call.node;
+		bool cycle = std::find(call.inputs.begin(), call.inputs.end(), node) != call.inputs.end();
+		calls.pop_back();
+		Visit& visit = visits[node];
+
+		if (!calls.empty()) {
+			Visit& caller = visits[calls.back().node];
+			caller.low = std::min(caller.low, visit.low);
+		}
+
+		if (visit.low != visit.order)
+			continue;
+
+		std::size_t begin = path.size();
+
+		do
+			visits[path[--begin]].onStack = false;
+		while (path[begin] != node);
+
+		cycle = cycle || path.size() - begin > 1;
+
+		for (std::size_t i = begin; i < path.size(); ++i) {
+			pending.erase(path[i]);
+
+			if (cycle) {
+				cells.setError(path[i]);
+				refreshCell(path[i]);
+			}
+			else
+				evaluateFormula(path[i]);
+		}
+
+		path.resize(begin);
+	}
+}
+
+/**
+ * @brief				Gives the pending formula cells a formula cell depends on,
+ * 						those it refers to and those in the ranges it aggregates
+ *
+ * @param [in]	index	Absolute index of the formula cell
+ *
+ * @returns				Absolute indices of the pending inputs, possibly repeated
+ */
+
+std::vector<std::size_t> Table::pendingInputs(std::size_t index) const {
+	const Formula& formula = formulas->at(index);
+	std::vector<std::size_t> inputs;
+
+	for (std::size_t reference : formula.references)
+		if (pending.contains(reference))
+			inputs.push_back(reference);
+
+	for (const Formula::Range& range : formula.ranges)
+		for (int col = range.firstColumn; col <= range.lastColumn; ++col)
+			for (int row = pending.next(col, range.firstRow, range.lastRow); row <= range.lastRow; row = pending.next(col, row + 1, range.lastRow))
+				inputs.push_back(getIndexCell(row, col));
+
+	return inputs;
+}
+
+/**
+ * @brief					Recalculates the formula cells downstream of the changed cells,
+ * 							the cells themselves included if they are formulas. The affected
+ * 							part of the dependency graph is split into strongly connected
+ * 							components by an iterative Tarjan search, which yields them in
+ * 							reverse topological order. Components forming a cycle are turned
+ * 							into error cells, the rest are evaluated in topological order,
+ * 							so every formula is evaluated once, after all of its inputs.
+ * 							Large recalculations are grouped into dependency levels, each
+ * 							level depending only on earlier ones, and the cells of a level
+ * 							are evaluated concurrently on the shared thread pool. Every cell
+ * 							still sees the same inputs, so results match serial evaluation
+ *
+ * @param [in]	origins		Absolute indices of the changed cells
+ *
+ */
+
+void Table::recalculate(const std::vector<std::size_t>& origins) {
+	std::size_t position = 0, dependent;
+
+	if (origins.size() == 1 && !nextDependent(origins.front(), position, dependent)) {
+		if (formulas->count(origins.front()))
+			evaluateFormula(origins.front());
+
+		return;
+	}
+
+	struct Visit
+	{
+		int order, low;
+		std::size_t level;
+		bool onStack;
+	};
+
+	std::unordered_map<std::size_t, Visit> visits;
+	std::vector<std::pair<std::size_t, std::size_t>> calls;
+	std::vector<std::size_t> path, components, componentEnds;
+	int counter = 0;
+
+	auto enter = [&](std::size_t node) {
+		visits[node] = { counter, counter, 0, true };
+		++counter;
+		path.push_back(node);
+		calls.push_back({ node, 0 });
+	};
+
+	for (std::size_t origin : origins) {
+		if (visits.count(origin))
+			continue;
+
+		enter(origin);
+
+		while (!calls.empty()) {
+			std::size_t node = calls.back().first, next;
+
+			if (nextDependent(node, calls.back().second, next)) {
+				auto visit = visits.find(next);
+
+				if (visit == visits.end())
+					enter(next);
+				else if (visit->second.onStack)
+					visits[node].low = std::min(visits[node].low, visit->second.order);
+
+				continue;
+			}
+
+			calls.pop_back();
+			Visit& visit = visits[node];
+
+			if (!calls.empty()) {
+				Visit& caller = visits[calls.back().first];
+				caller.low = std::min(caller.low, visit.low);
+			}
+
+			if (visit.low == visit.order) {
+				std::size_t member;
+
+				do {
+					member = path.back();
+					path.pop_back();
+					visits[member].onStack = false;
+					components.push_back(member);
+				} while (member != node);
+
+				componentEnds.push_back(components.size());
+			}
+		}
+	}
+
+	if (componentEnds.size() < PARALLEL_THRESHOLD || ThreadPool::shared().size() == 1) {
+		for (size_t i = componentEnds.size(); i-- > 0;) {
+			size_t begin = i == 0 ? 0 : componentEnds[i - 1], end = componentEnds[i];
+			bool cycle = isCycle(components[begin], end - begin);
+
+			for (size_t j = begin; j < end; ++j) {
+				if (!formulas->count(components[j]))
+					continue;
+
+				if (cycle) {
+					cells.setError(components[j]);
+					refreshCell(components[j]);
+				}
+				else
+					evaluateFormula(components[j]);
+			}
+		}
+
+		return;
+	}
+
+	std::vector<std::vector<std::size_t>> levels;
+	invalidateFrame();
+
+	for (size_t i = componentEnds.size(); i-- > 0;) {
+		size_t begin = i == 0 ? 0 : componentEnds[i - 1], end = componentEnds[i];
+		bool cycle = isCycle(components[begin], end - begin);
+		std::size_t level = 0;
+
+		for (size_t j = begin; j < end; ++j)
+			level = std::max(level, visits[components[j]].level);
+
+		for (size_t j = begin; j < end; ++j) {
+			for (position = 0; nextDependent(components[j], position, dependent);)
+				visits[dependent].level = std::max(visits[dependent].level, level + 1);
+
+			if (!formulas->count(components[j]))
+				continue;
+
+			if (cycle)
+				cells.setError(components[j]);
+			else {
+				if (levels.size() <= level)
+					levels.resize(level + 1);
+
+				levels[level].push_back(components[j]);
+			}
+		}
+	}
+
+	for (const std::vector<std::size_t>& level : levels) {
+		if (level.size() < PARALLEL_LEVEL_SIZE) {
+			for (std::size_t index : level)
+				evaluateFormula(index);
+
+			continue;
+		}
+
+		cells.unshare();
+		ThreadPool::shared().parallelFor(level.size(), [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+				evaluateFormula(level[i]);
+		});
+	}
+}
+
+/**
+ * @brief					Checks if a strongly connected component of the dependency
+ * 							graph is a cycle, either of several cells or of a cell
+ * 							referring to itself
+ *
+ * @param [in]	node		Any cell of the component
+ *
+ * @param [in]	size		Number of cells in the component
+ *
+ * @returns					True if the component is a cycle
+ */
+
+bool Table::isCycle(std::size_t node, std::size_t size) const {
+	if (size > 1)
+		return true;
+
+	std::size_t position = 0, dependent;
+
+	while (nextDependent(node, position, dependent))
+		if (dependent == node)
+			return true;
+
+	return false;
+}
+
+/**
+ * @brief						Walks the formula cells depending on a cell, first those
+ * 								referring to it, then those aggregating a range holding it,
+ * 								node by node up the segment tree of ranges of its column
+ *
+ * @param [in]		node		Absolute index of the cell
+ *
+ * @param [in,out]	position	Position of the walk, 0 to start, advanced past the
+ * 								dependent found
+ *
+ * @param [out]		dependent	Absolute index of the next dependent
+ *
+ * @returns						True if a dependent was found, false once all were walked
+ */
+
+bool Table::nextDependent(std::size_t node, std::size_t& position, std::size_t& dependent) const {
+	auto edges = dependents.find(node);
+	std::size_t count = edges == dependents.end() ? 0 : edges->second.size();
+
+	if (position < count) {
+		dependent = edges->second[position++];
+		return true;
+	}
+
+	if (rangeDependents.empty())
+		return false;
+
+	std::size_t leaf = rangeLeaves() + node / columns;
+	std::size_t level = (position - count) % RANGE_LEVELS, offset = (position - count) / RANGE_LEVELS;
+
+	for (; (leaf >> level) > 0; ++level, offset = 0) {
+		auto ranges = rangeDependents.find((std::uint64_t)(leaf >> level) * columns + node % columns);
+
+		if (ranges != rangeDependents.end() && offset < ranges->second.size()) {
+			dependent = ranges->second[offset];
+			position = count + (offset + 1) * RANGE_LEVELS + level;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief	Gives the number of leaves of the segment trees of ranges, the
+ * 			number of rows rounded up to a power of two
+ *
+ * @returns	Number of leaves
+ */
+
+std::size_t Table::rangeLeaves() const {
+	std::size_t leaves = 1;
+
+	while (leaves < (std::size_t)rows)
+		leaves *= 2;
+
+	return leaves;
+}
+
+/**
+ * @brief				Gives the keys of the nodes of the segment trees of ranges
+ * 						a range is listed at, at most two per level for each column
+ *
+ * @param [in]	range	Range of cells
+ *
+ * @returns				Keys of the nodes covering the range
+ */
+
+std::vector<std::uint64_t> Table::rangeKeys(const Formula::Range& range) const {
+	std::vector<std::uint64_t> keys;
+
+	if (range.firstRow > range.lastRow)
+		return keys;
+
+	std::size_t leaves = rangeLeaves();
+
+	for (int col = range.firstColumn; col <= range.lastColumn; ++col) {
+		for (std::size_t low = leaves + range.firstRow, high = leaves + range.lastRow + 1; low < high; low /= 2, high /= 2) {
+			if (low % 2 == 1)
+				keys.push_back((std::uint64_t)low++ * columns + col);
+
+			if (high % 2 == 1)
+				keys.push_back((std::uint64_t)--high * columns + col);
+		}
+	}
+
+	return keys;
+}
+
+/**
+ * @brief				Check if given cell is in table range
+ *
+ * @param [in]	row		The cell' row
+ *
+ * @param [in] 	col		The cell' column
+ *
+ * @returns				True if cell is valid, false if out of range
+ */
+
+bool Table::cellExists(int row, int col) const {
+	return row > 0 && col > 0 && row <= rows && col <= columns;
+}
+
+/**
+ * @brief							Edit the value of given cell
+ *
+ * @param [in]	row					The cell' row
+ *
+ * @param [in] 	col					The cell' column
+ *
+ * @param [in] 	str					New cell value
+ *
+ * @param [in] 	supressMessages		If set to true (false by default), no messages will be printed out,
+ * 									apart from evalatuion errors (ex. dividing by zero)
+ *
+ */
+
+void Table::editCell(int row, int col, std::string_view str, bool supressMessages) {
+	if (!cellExists(row, col)) {
+		if (!supressMessages)
+			Console::error() << "Invalid cell! Editing unsuccesful" << std::endl;
+
+		return;
+	}
+
+	createCell(getIndexCell(row - 1, col - 1), str, supressMessages);
+
+	if (!supressMessages)
+		Console::out() << "Cell edited succesfully!" << std::endl;
+}
+
+/**
+ * @brief	Prints the table in format that every column is the same width
+ * 			aligned according to the longest cell present there. Cell values
+ * 			are enclosed by '|' symbol. The whole table is rendered into a
+ * 			frame kept until a change invalidates it, so printing an unchanged
+ * 			table only writes the frame again. Frames of very large tables are
+ * 			not kept. Pending formula cells are evaluated first
+ *
+ */
+
+void Table::print() {
+	settle();
+	render();
+}
+
+/**
+ * @brief	Gets the table ready to be printed: evaluates pending formula cells
+ * 			and builds the frame if it is to be kept, so the table is settled
+ * 			and printing it or a version of it changes nothing
+ *
+ */
+
+void Table::settle() {
+	evaluate();
+
+	if (!frameValid && (std::size_t)rows * columns <= FRAME_CACHE_CELLS)
+		buildFrame();
+}
+
+/**
+ * @brief	Writes the table out as print() does, without evaluating anything
+ * 			or keeping a frame: the kept frame is written at once, otherwise
+ * 			rows are written out in chunks as they are rendered. Leaves the
+ * 			table as it is, so versions of a table are printed with it
+ *
+ */
+
+void Table::render() const {
+	if (frameValid) {
+		frame.write(Console::out());
+		Console::out().flush();
+		Stats::add(Stats::BytesWritten, frame.size());
+		return;
+	}
+
+	std::vector<std::uint32_t> widths(columns, 0);
+	calculateColumnWidths(widths);
+
+	std::string output, buffer;
+	output.reserve(OUTPUT_CHUNK_SIZE);
+
+	for (int i = 0; i < rows && columns > 0; ++i) {
+		for (int j = 0; j < columns; ++j) {
+			for (int next = cells.skipEmpty(i, j); j < next; ++j)
+				appendCell(output, "", widths[j]);
+
+			if (j < columns)
+				appendCell(output, displayString(getIndexCell(i, j), buffer), widths[j]);
+		}
+
+		output.append("|\n");
+
+		if (output.size() >= OUTPUT_CHUNK_SIZE) {
+			writeOutput(output);
+			output.clear();
+		}
+	}
+
+	writeOutput(output);
+}
+
+/**
+ * @brief	Renders the whole table into the frame, recording the display
+ * 			width of every cell. Every cell is formatted once: the display
+ * 			strings are collected first and padded to their column width
+ * 			once all widths are known
+ *
+ */
+
+void Table::buildFrame() const {
+	std::string strings, buffer;
+	displayWidths.assign((std::size_t)rows * columns, 0);
+	columnWidths.assign(columns, 0);
+	widestCells.assign(columns, 0);
+	columnOffsets.assign(columns, 0);
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = cells.skipEmpty(i, 0); j < columns; j = cells.skipEmpty(i, j + 1)) {
+			std::size_t index = getIndexCell(i, j);
+			std::string_view str = displayString(index, buffer);
+
+			displayWidths[index] = str.size();
+			columnWidths[j] = std::max<std::uint32_t>(columnWidths[j], str.size());
+			strings.append(str);
+		}
+	}
+
+	std::size_t rowLength = 2;
+
+	for (int j = 0; j < columns; ++j) {
+		columnOffsets[j] = rowLength;
+		rowLength += columnWidths[j] + 3;
+
+		if (columnWidths[j] == 0)
+			widestCells[j] = rows;
+	}
+
+	std::string rendered;
+	rendered.reserve(columns > 0 ? rows * rowLength : 0);
+	std::size_t position = 0;
+
+	for (int i = 0; i < rows && columns > 0; ++i) {
+		for (int j = 0; j < columns; ++j) {
+			std::size_t index = getIndexCell(i, j);
+			std::uint32_t width = displayWidths[index];
+
+			appendCell(rendered, std::string_view(strings.data() + position, width), columnWidths[j]);
+			position += width;
+
+			if (width > 0 && width == columnWidths[j])
+				++widestCells[j];
+		}
+
+		rendered.append("|\n");
+	}
+
+	frame.assign(rendered.data(), rendered.size());
+	frameValid = true;
+}
+
+/**
+ * @brief				Brings the kept frame up to date after a cell has changed.
+ * 						As long as the widths of the columns stay the same, the new
+ * 						display string of the cell is written over its old place in
+ * 						the frame. A change that widens a column, or narrows it by
+ * 						shrinking its last widest cell, drops the frame instead
+ *
+ * @param [in]	index	Absolute index of the changed cell
+ *
+ */
+
+void Table::refreshCell(std::size_t index) {
+	if (!frameValid)
+		return;
+
+	int col = index % columns;
+	std::uint32_t width = columnWidths[col];
+	std::uint32_t oldWidth = displayWidths[index];
+	std::string buffer;
+	std::string_view str = displayString(index, buffer);
+
+	if (str.size() > width || (oldWidth == width && str.size() < width && widestCells[col] == 1)) {
+		invalidateFrame();
+		return;
+	}
+
+	widestCells[col] += (str.size() == width) - (oldWidth == width);
+	displayWidths[index] = str.size();
+
+	std::size_t position = (index / columns) * (frame.size() / rows) + columnOffsets[col];
+	std::string padded(width - str.size(), ' ');
+	padded.append(str);
+
+	for (std::size_t k = 0; k < padded.size(); ++k)
+		frame.set(position + k, padded[k]);
+}
+
+/**
+ * @brief	Drops the kept frame, it is rendered again on the next print
+ *
+ */
+
+void Table::invalidateFrame() {
+	if (!frameValid)
+		return;
+
+	frameValid = false;
+	frame.assign(0, ' ');
+	std::vector<std::uint32_t>().swap(displayWidths);
+}
+
+/**
+ * @brief					Gives the text a cell is printed as, texts without quotes.
+ * 							Texts are given from the text pool without a copy, other
+ * 							cells are formatted into the buffer
+ *
+ * @param [in]		index	Absolute index of the cell
+ *
+ * @param [in,out]	buffer	Buffer the cell is formatted into, unless a text
+ *
+ * @returns					Display string of the cell, valid until the buffer
+ * 							or the cell changes
+ */
+
+std::string_view Table::displayString(std::size_t index, std::string& buffer) const {
+	if (cells.type(index) == CellType::Text)
+		return cells.text(index);
+
+	buffer = cells.toString(index);
+	return buffer;
+}
+
+/**
+ * @brief	               Stream insertion operator for Table objects.
+ * 						   Formula cells are written as their formula text.
+ * 						   Rows are rendered into a buffer written out in chunks
+ *
+ * @param [in,out]   os	   The output stream
+ *
+ * @param [in] 	     t     Table to be streamed
+ *
+ * @returns	               The streamed table object
+ *
+ */
+
+std::ostream& operator<<(std::ostream& os, const Table& t) {
+	char delimeter = ',';
+	std::string output;
+	output.reserve(OUTPUT_CHUNK_SIZE);
+
+	for (int i = 0; i < t.rows; ++i) {
+		for (int j = 0; j < t.columns; ++j) {
+			int next = t.cells.skipEmpty(i, j);
+
+			if (next > j) {
+				output.append(next - j, delimeter);
+				j = next - 1;
+			}
+
+			else {
+				std::size_t index = t.getIndexCell(i, j);
+				CellType type = t.cells.type(index);
+
+				if (type == CellType::Formula || (type == CellType::Error && t.formulas->count(index)))
+					output.append(t.formulas->at(index).getSource());
+				else if (type == CellType::Text) {
+					output.push_back('"');
+					output.append(t.cells.text(index));
+					output.push_back('"');
+				}
+
+				else
+					output.append(t.cells.toString(index));
+
+				output.push_back(delimeter);
+			}
+		}
+
+		output.push_back('\n');
+
+		if (output.size() >= OUTPUT_CHUNK_SIZE) {
+			if (!os.write(output.data(), output.size()))
+				return os;
+
+			Stats::add(Stats::BytesWritten, output.size());
+			output.clear();
+		}
+	}
+
+	os.write(output.data(), output.size());
+	Stats::add(Stats::BytesWritten, output.size());
+	return os;
+}
+
+/**
+ * @brief		Gets cell absolute index from
+ * 				given row and column
+ *
+ * @param 	x	cell row
+ *
+ * @param 	y	cell column
+ *
+ * @returns		Absolute index of cell
+ */
+
+std::size_t Table::getIndexCell(int x, int y) const {
+	return (std::size_t)x * columns + y;
+}
+
+/**
+ * @brief							Calculates the table column widths according to
+ * 									the longest string value encounntered
+ *
+ * @param [in,out]	widths			Table column widths
+ *
+ */
+
+void Table::calculateColumnWidths(std::vector<std::uint32_t>& widths) const {
+	std::string buffer;
+
+	for (int i = 0; i < rows; ++i)
+		for (int j = cells.skipEmpty(i, 0); j < columns; j = cells.skipEmpty(i, j + 1))
+			widths[j] = std::max<std::uint32_t>(widths[j], displayString(getIndexCell(i, j), buffer).size());
+}
+
+/**
+ * @brief					Appends a printed cell to rendered output, its display
+ * 							string aligned to the right of its column
+ *
+ * @param [in,out]	output	Rendered output
+ *
+ * @param [in]		str		Display string of the cell
+ *
+ * @param [in]		width	Width of the column
+ */
+
+void appendCell(std::string& output, std::string_view str, std::size_t width) {
+	output.append("| ");
+	output.append(width - str.size(), ' ');
+	output.append(str);
+	output.push_back(' ');
+}
+
+/**
+ * @brief				Writes rendered output to the console in a single write
+ *
+ * @param [in]	output	Rendered output
+ */
+
+void writeOutput(const std::string& output) {
+	Console::out().write(output.data(), output.size());
+	Console::out().flush();
+	Stats::add(Stats::BytesWritten, output.size());
+}
+
+/**
+ * @brief				Checks if a value can be assigned to a cell without
+ * 						turning it into an error cell
+ *
+ * @param [in]	str		Cell value
+ *
+ * @returns				True if the value is empty, a number, quoted text or a formula
+ */
+
+bool isValidValue(std::string_view str) {
+	str = StringUtils::trim(str);
+
+	return str.empty() || StringUtils::isQuotedText(str) || StringUtils::isNumber(str) || StringUtils::isFormula(str);
+}
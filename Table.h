@@ -1,55 +1,248 @@
-#ifndef TABLE_H
-#define TABLE_H
-
-#include "Cell.h"
-#include <optional>
-#include <vector>
-
-/**
- * @class	Table
- *
- * @brief	Class representing a table entity
- * 			containing cells from diferent types
- *
- */
-
-class Table
-{
-public:
-	Table(int, int);
-	~Table();
-
-	Cell* createCell(std::string&, bool = false);
-	void editCell(int, int, std::string&, bool = false);
-	void print() const;
-	friend std::ostream& operator<<(std::ostream&, const Table&);
-	std::optional<double> calculateFormula(const std::string&) const;
-
-private:
-	/**
-	* @brief Number of table rows
-	*/
-
-	int rows;
-
-	/**
-	* @brief Number of table columns
-	*/
-
-	int columns;
-
-	/**
-	* @brief Table cells
-	*/
-
-	Cell** table;
-
-	bool cellExists(int, int) const;
-	int getIndexCell(int x, int y) const;
-	double evaluateReference(const std::string&) const;
-	void calculateColumnWidths(int* columnWidths) const;
-
-};
-
-#endif
-
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "CellStore.h"
+#include "CellSet.h"
+#include "Formula.h"
+#include "CopyOnWrite.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+struct Sheet;
+class Workbook;
+
+/**
+ * @struct	CellEdit
+ *
+ * @brief	New value of a cell, as applied by Table::applyEdits
+ */
+
+struct CellEdit
+{
+	int row, col;
+	std::string_view value;
+};
+
+/**
+ * @enum	EvaluationMode
+ *
+ * @brief	When formula cells are evaluated. Eager tables evaluate them as
+ * 			soon as their inputs change, lazy tables mark them pending and
+ * 			evaluate them when they are first read
+ *
+ */
+
+enum class EvaluationMode
+{
+	Eager,
+	Lazy
+};
+
+/**
+ * @class	Table
+ *
+ * @brief	Class representing a table entity
+ * 			containing cells from diferent types,
+ * 			kept in a compact cell store
+ *
+ */
+
+class Table
+{
+	friend class Snapshot;
+
+public:
+	Table(int, int, StorageMode = StorageMode::Dense);
+	Table(const Table&);
+	Table& operator=(const Table&) = delete;
+
+	void createCell(std::size_t, std::string_view, bool = false);
+	void editCell(int, int, std::string_view, bool = false);
+	void setCell(int, int, std::string_view);
+	std::optional<std::size_t> applyEdits(const std::vector<CellEdit>&);
+	void setCells(const std::vector<CellEdit>&);
+	void resize(int, int, StorageMode = StorageMode::Dense);
+	void recalculate();
+	void reserveFormulas(std::size_t);
+	void evaluate();
+	void setEvaluationMode(EvaluationMode);
+	std::optional<std::string> getValue(int, int);
+	void setWorkbook(Workbook*);
+	void moveRows(Table&, int);
+	int getRows() const;
+	int getColumns() const;
+	std::size_t memoryUsage() const;
+	bool isSettled() const;
+	std::shared_ptr<const Table> version(bool = true) const;
+	void print();
+	void settle();
+	void render() const;
+	friend std::ostream& operator<<(std::ostream&, const Table&);
+	std::optional<double> calculateFormula(const Formula&) const;
+
+private:
+	/**
+	* @brief Number of table rows
+	*/
+
+	int rows;
+
+	/**
+	* @brief Number of table columns
+	*/
+
+	int columns;
+
+	/**
+	* @brief Table cells
+	*/
+
+	CellStore cells;
+
+	/**
+	* @brief Formulas of the formula cells keyed by cell index, shared
+	* 		 with the versions of the table until changed
+	*/
+
+	CopyOnWrite<std::unordered_map<std::size_t, Formula>> formulas;
+
+	/**
+	* @brief Dependency graph: the formula cells referring to each cell
+	*/
+
+	std::unordered_map<std::size_t, std::vector<std::size_t>> dependents;
+
+	/**
+	* @brief Dependency graph of ranges: the formula cells aggregating rows of
+	* 		 each column, kept per column rather than per cell. Every column has
+	* 		 a segment tree over its rows, a range is listed at the O(log n) nodes
+	* 		 covering its rows, so the ranges holding a cell are on the path from
+	* 		 its row to the root. Keyed by node * columns + column
+	*/
+
+	std::unordered_map<std::uint64_t, std::vector<std::size_t>> rangeDependents;
+
+	/**
+	* @brief When formula cells are evaluated
+	*/
+
+	EvaluationMode evaluation;
+
+	/**
+	* @brief Formula cells of a lazy table not evaluated since their inputs
+	* 		 changed. Every formula cell depending on one is pending as well
+	*/
+
+	CellSet pending;
+
+	/**
+	 * @struct	ExternalSheet
+	 *
+	 * @brief	Sheet the formulas of the table refer to, with the formula cells
+	 * 			referring to it and the version of it they were last evaluated
+	 * 			against. The handle is looked up by name once and kept
+	 */
+
+	struct ExternalSheet
+	{
+		std::string name;
+		Sheet* sheet;
+		std::uint64_t generation, revision;
+		std::vector<std::size_t> formulas;
+	};
+
+	/**
+	* @brief Sheets referred to by formulas, in order of first reference. Formulas
+	* 		 refer to them by position, so they are kept until the formulas are
+	* 		 compiled again
+	*/
+
+	std::vector<ExternalSheet> externalSheets;
+
+	/**
+	* @brief Workbook the sheets referred to are looked up in, if any
+	*/
+
+	Workbook* workbook;
+
+	/**
+	* @brief Number of changes made to the cells, so tables referring to the
+	* 		 table can tell when to evaluate their references again
+	*/
+
+	std::uint64_t revision;
+
+	/**
+	* @brief True while the references to other sheets are brought up to date
+	*/
+
+	bool refreshing;
+
+	/**
+	* @brief Table as last printed, kept while frameValid is set. Every row
+	* 		 has the same length, so each cell has a fixed place in it. Kept
+	* 		 in pages shared with the versions of the table until changed
+	*/
+
+	mutable CellArray<char> frame;
+
+	/**
+	* @brief True if the frame and the display widths match the cells
+	*/
+
+	mutable bool frameValid;
+
+	/**
+	* @brief Display width of every cell, kept along with the frame
+	*/
+
+	mutable std::vector<std::uint32_t> displayWidths;
+
+	/**
+	* @brief Width of every column of the frame
+	*/
+
+	mutable std::vector<std::uint32_t> columnWidths;
+
+	/**
+	* @brief Number of cells of every column as wide as the column itself
+	*/
+
+	mutable std::vector<std::uint32_t> widestCells;
+
+	/**
+	* @brief Offset of every column of the frame within a row
+	*/
+
+	mutable std::vector<std::size_t> columnOffsets;
+
+	bool cellExists(int, int) const;
+	std::size_t getIndexCell(int x, int y) const;
+	void calculateColumnWidths(std::vector<std::uint32_t>&) const;
+	std::string_view displayString(std::size_t, std::string&) const;
+	void buildFrame() const;
+	void refreshCell(std::size_t);
+	void invalidateFrame();
+	void linkFormula(std::size_t, Formula&&);
+	void unlinkFormula(std::size_t);
+	void evaluateFormula(std::size_t);
+	void evaluatePending(std::size_t);
+	std::vector<std::size_t> pendingInputs(std::size_t) const;
+	void propagate(const std::vector<std::size_t>&);
+	void refreshExternals();
+	std::optional<double> calculateAggregate(Formula::Instruction::Code, const Formula::Range&) const;
+	void assignCell(std::size_t, std::string_view, bool);
+	void recalculate(const std::vector<std::size_t>&);
+	bool isCycle(std::size_t, std::size_t) const;
+	bool nextDependent(std::size_t, std::size_t&, std::size_t&) const;
+	std::size_t rangeLeaves() const;
+	std::vector<std::uint64_t> rangeKeys(const Formula::Range&) const;
+
+};
+
+#endif
+
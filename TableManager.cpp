@@ -1,384 +1,1312 @@
-#include "TableManager.h"
-#include "StringUtils.h"
-#include <iostream>
-#include <string>
-#include <functional>
-#include <map>
-#include <algorithm>
-#include <fstream>
-
-bool validateFileExtension(const std::string&);
-bool validateFileName(const std::string&);
-
-/**
- * @brief	Default constructor creating with no table
- * 			present and empty data file
- *
- */
-
-TableManager::TableManager() :table(nullptr), file("") {
-}
-
-/**
- * @brief	Destructor destroying the object and taking care
- * 			of allocated dynamic memory
- *
- */
-
-TableManager::~TableManager() {
-	if (table != nullptr)
-		delete table;
-}
-
-/**
- * @brief	Starts the command console to read user commands
- *
- */
-
-void TableManager::startConsole() {
-	std::cout << "Open a text file (.txt) to read: (open <file>.txt)" << std::endl;
-	std::string userInput;
-
-	while (true) {
-		std::getline(std::cin, userInput);
-		executeCommand(userInput);
-	};
-}
-
-/**
- * @brief    Prints available user commands
- *
- */
-
-void TableManager::help() const {
-	std::cout << "open <file>                  opens <file>\n"
-		<< "close                        closes currently opened file\n"
-		<< "save                         saves the currently open file\n"
-		<< "saveas <file>                saves the currently open file in <file>\n"
-		<< "help                         prints this information\n"
-		<< "print                        print the current table\n"
-		<< "edit <row> <col> <value>     print the current table\n"
-		<< "exit                         exists the program" << std::endl;
-}
-
-/**
- * @brief    Exits the programme
- *
- */
-
-void TableManager::exit() {
-	std::cout << "Programme terminated succesfully!" << std::endl;
-	std::exit(0);
-}
-
-/**
- * @brief    Closes the current open file and clears any data read
- *
- */
-
-void TableManager::close() {
-	if (table != nullptr) {
-		delete table;
-		table = nullptr;
-	}
-
-	std::cout << "Succesfully closed current file!" << std::endl;
-	file = "";
-}
-
-/**
- * @brief    Prints the table if present
- *
- */
-
-void TableManager::print() const {
-	if (table != nullptr)
-		table->print();
-}
-
-/**
- * @brief	           Opens a file to read from
- *
- * @param [in]  file   File to read
- *
- */
-
-void TableManager::open(const std::string& file) {
-	std::fstream myFile(file, std::ios::app);
-
-	if (myFile.is_open()) {
-		std::cout << "Succesfully opened file " << file << "!" << std::endl;
-		myFile.close();
-		readFile(file);
-	}
-
-	else
-		std::cout << "Error opening the file!" << std::endl;
-
-}
-
-/**
- * @brief	           Read data from a given file
- *
- * @param [in]  file   File to read
- *
- */
-
-void TableManager::readFile(const std::string& file) {
-	std::ifstream myFile(file, std::ios::in);
-
-	if (!myFile.is_open()) {
-		std::cout << "Error opening the file!" << std::endl;
-		return;
-	}
-
-	this->file = file;
-	char delimeter = ',';
-	int rows = 0, maxColumns = 0, countTokens = 0;
-	std::string line;
-
-	while (std::getline(myFile, line)) {
-		++rows;
-		int countTokens = std::count(line.begin(), line.end(), delimeter);
-		if (countTokens > maxColumns)
-			maxColumns = countTokens;
-	}
-
-	myFile.close();
-
-	if (rows == 0) {
-		table = new Table(10, 10);
-		std::cout << "File empty! Generated default 10x10 empty table" << std::endl;
-	}
-
-	else {
-		table = new Table(rows, maxColumns);
-		populateTable(file, delimeter);
-	}
-}
-
-/**
- * @brief				   Read data and populate table from file. If given row has
- * 						   more cells than another one, the second is autofilled with empty cells
- *
- * @param  [in]	  file 	   The file to read
- *
- * @param  [in]	  delim	   The delimiter used in data file
- */
-
-void TableManager::populateTable(const std::string& file, char delim) {
-	std::ifstream myFile(file, std::ios::in);
-	std::string line;
-	int row = 0;
-	while (std::getline(myFile, line)) {
-		++row;
-
-		if (!line.empty()) {
-			int col = 0;
-			size_t pos = 0;
-			std::string token, delimeter = std::string(1, delim);
-			while ((pos = line.find(delimeter)) != std::string::npos) {
-				++col;
-				token = line.substr(0, pos);
-				if (!token.empty()) {
-					table->editCell(row, col, token, true);
-				}
-
-				line.erase(0, pos + delimeter.length());
-			}
-		}
-	}
-}
-
-/**
- * @brief    Saves the current data in the current file
- *
- */
-
-
-void TableManager::save() {
-	assert(!file.empty());
-
-	std::fstream myFile(file, std::ios::out | std::ios::trunc);
-
-	if (myFile.is_open()) {
-		myFile << *table;
-		myFile.close();
-		std::cout << "Table saved successfully!" << std::endl;
-	}
-
-	else
-		std::cout << "Error opening the file!" << std::endl;
-}
-
-/**
- * @brief			   Writes current data to the file specified
- *
- * @param [in]  file   File to write data to
- *
- */
-
-void TableManager::saveAs(const std::string& file) {
-	std::ofstream myFile(file, std::ios::out | std::ios::trunc);
-
-	if (myFile.is_open()) {
-		myFile << *table;
-		myFile.close();
-		std::cout << "Table saved successfully as " << file << "!" << std::endl;
-	}
-
-	else
-		std::cout << "Error opening the file!" << std::endl;
-}
-
-/**
- * @brief			Validates if the given file is .txt format and
- * 					its name is valid
- *
- * @param 	file	The file.
- *
- * @returns			True if file is valid, false if it fails.
- */
-
-bool TableManager::validateFile(const std::string& file) {
-	if (file.size() < 5) {
-		std::cout << "Filename too short! (Hint: File format should be filename.txt)" << std::endl;
-		return false;
-	}
-
-	std::string name = file.substr(0, file.size() - 4);
-	std::string extension = file.substr(file.size() - 4, 4);
-	std::string forbiddenSymbols = "/\?%*:|\"<>.";
-
-	return validateFileExtension(extension) && validateFileName(name);
-}
-
-/**
- * @brief				Checks if file extension is '.txt'
- *
- * @param 	extension	File extension
- *
- * @returns				True if it is .txt, false otherwise
- *
- */
-
-bool validateFileExtension(const std::string& extension) {
-	bool result = true;
-
-	if (extension != ".txt") {
-		std::cout << "Invalid file extension! (Hint: File should be .txt)" << std::endl;
-		result = false;
-	}
-
-	return result;
-}
-
-/**
- * @brief			Validates the file name.Name should not contain  any
- * 					forbidden OS characters specified by the Windows OS
- *
- * @param 	name	File name
- *
- * @returns			True if it is valid, false otherwise
- *
- */
-
-bool validateFileName(const std::string& name) {
-	assert(!name.empty() && "Name should not be empty string");
-
-	bool result = true;
-
-	std::string badChars = "/\?%*:|\"<>.";
-	std::size_t badChar = name.find_first_of(badChars);
-
-	if (badChar != std::string::npos) {
-		std::cout << "Invalid file name! (Hint: Check forbidden filename characters in Windows OS)" << std::endl;
-		result = false;
-	}
-
-	return result;
-}
-
-/**
- * @brief	             Edit given cell with the value specified
- *
- * @param [in]  args	 User console input specifying the cell and the new value
- *
- */
-
-void TableManager::edit(const std::string& args) {
-	int firstDelim = -1, secondDelim = -1;
-	char delimeter = ' ';
-
-	for (size_t i = 0; i < args.size() - 1; ++i) {
-		if (args.at(i) == delimeter)
-			if (firstDelim == -1)
-				firstDelim = i;
-			else {
-				secondDelim = i;
-				break;
-			}
-	}
-
-	if (secondDelim != -1) {
-		std::string stringRow = args.substr(0, firstDelim), stringCol = args.substr(firstDelim + 1, secondDelim - firstDelim - 1);
-		std::string  value = args.substr(secondDelim + 1);
-
-		if (StringUtils::isInteger(stringRow) && StringUtils::isInteger(stringCol)) {
-			int row = std::stoi(stringRow), col = std::stoi(stringCol);
-
-			table->editCell(row, col, value);
-			return;
-		}
-	}
-
-	std::cout << "Invalid command! (Hint: Command should be: edit <row> <col> <value>)" << std::endl;
-}
-
-/**
- * @brief	              Executes a console-typed user command. If the given input
- * 						  does not match any command, proper error message is printed
- *
- * @param [in]  command	  User console input
- *
- */
-
-void TableManager::executeCommand(std::string& command) {
-	StringUtils::trim(command);
-
-	if (command.size() < 4) {
-		std::cout << "Command too short" << std::endl;
-		return;
-	}
-
-	if (file.empty()) {
-		if (command.size() >= 10 && command.substr(0, 5) == "open ") {
-			std::string file = command.substr(5);
-			if (validateFile(file)) {
-				open(file);
-			}
-		}
-		else
-			std::cout << "Invalid command!" << std::endl;
-	}
-
-	else if (functions.find(command) != functions.end())
-		functions.at(command)();
-
-
-	else if (command.substr(0, 7) == "saveas ") {
-		std::string file = command.substr(7);
-		if (validateFile(file)) {
-			saveAs(file);
-		}
-	}
-
-	else if (command.substr(0, 5) == "edit ") {
-		std::string commandArguments = command.substr(5);
-		edit(commandArguments);
-	}
-
-	else
-		std::cout << "Invalid command! (Hint: type help to see available commands)" << std::endl;
-};
-
+#include "TableManager.h"
+#include "StringUtils.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Snapshot.h"
+#include "EditJournal.h"
+#include "Stats.h"
+#include "Console.h"
+#include <iostream>
+#include <string>
+#include <functional>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <filesystem>
+#include <chrono>
+#include <streambuf>
+#include <vector>
+
+bool validateFileExtension(const std::string&);
+bool validateFileName(const std::string&);
+StorageMode chooseStorageMode(std::size_t, std::size_t);
+bool parseEdit(std::string_view, CellEdit&);
+std::string readConsoleEdits();
+
+/**
+ * Tables with fewer than one in this many cells filled are stored sparse
+ */
+
+const int SPARSE_OCCUPANCY = 8;
+
+/**
+ * Smallest data file chunk worth loading on a thread of its own, in bytes
+ */
+
+const std::size_t MIN_CHUNK_SIZE = 1 << 20;
+
+/**
+ * Edit journal size, in bytes, below which saving never compacts it into the data file
+ */
+
+const std::uintmax_t MIN_JOURNAL_SIZE = 1 << 20;
+
+/**
+ * Saving compacts the edit journal once it grows past this fraction of the data file
+ */
+
+const std::uintmax_t JOURNAL_SIZE_RATIO = 4;
+
+/**
+ * Bytes of a file parsed between reports of progress and checks for cancellation
+ */
+
+const std::size_t PROGRESS_STEP = 1 << 16;
+
+/**
+ * Bytes of messages a script buffers before writing them out
+ */
+
+const std::size_t SCRIPT_OUTPUT_SIZE = 1 << 16;
+
+/**
+ * Exit status of a script whose commands all succeeded
+ */
+
+const int SCRIPT_SUCCEEDED = 0;
+
+/**
+ * Exit status of a script with a failed command or save
+ */
+
+const int SCRIPT_FAILED = 1;
+
+/**
+ * Exit status of a script that cannot be read
+ */
+
+const int SCRIPT_UNREADABLE = 2;
+
+/**
+ * @class	ScriptBuffer
+ *
+ * @brief	Stream buffer reading the commands of a script straight from its
+ * 			mapping, so lines are found in bulk rather than read one by one
+ *
+ */
+
+class ScriptBuffer : public std::streambuf
+{
+public:
+	ScriptBuffer(const char* data, std::size_t size) {
+		char* begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+};
+
+/**
+ * @class	OutputBuffer
+ *
+ * @brief	Stream buffer collecting the messages of a script and passing them
+ * 			on in blocks of SCRIPT_OUTPUT_SIZE bytes. Flushes, such as the one
+ * 			of every std::endl, are ignored until the buffer is drained
+ *
+ */
+
+class OutputBuffer : public std::streambuf
+{
+public:
+	OutputBuffer(std::streambuf* target) :target(target), buffer(SCRIPT_OUTPUT_SIZE) {
+		setp(buffer.data(), buffer.data() + buffer.size());
+	}
+
+	~OutputBuffer() {
+		drain();
+	}
+
+	void drain() {
+		target->sputn(pbase(), pptr() - pbase());
+		target->pubsync();
+		setp(buffer.data(), buffer.data() + buffer.size());
+	}
+
+protected:
+	int_type overflow(int_type c) override {
+		drain();
+
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+			sputc(traits_type::to_char_type(c));
+
+		return traits_type::not_eof(c);
+	}
+
+	int sync() override {
+		return 0;
+	}
+
+private:
+	/**
+	 * @brief	Buffer the messages are passed on to
+	 */
+
+	std::streambuf* target;
+
+	/**
+	 * @brief	Messages not passed on yet
+	 */
+
+	std::vector<char> buffer;
+};
+
+/**
+ * @brief	Default constructor creating with no table
+ * 			present and empty data file
+ *
+ */
+
+TableManager::TableManager() :table(nullptr), file(""), evaluation(EvaluationMode::Eager),
+	workbook([this](const std::string& file) { return loadSheet(file); }),
+	jobs([this](std::string& command) { runCommand(command); workbook.trim(); }), scripted(false) {
+}
+
+/**
+ * @brief	Starts the command console to read user commands. Every command
+ * 			is timed, the latencies are kept by the name of the command.
+ * 			Sheets over the memory budget are evicted between commands,
+ * 			by the thread running them, never while a job uses the sheets.
+ * 			Opening files and applying batches from files run in the
+ * 			background, the commands read meanwhile are queued behind
+ * 			them, except for progress and cancel, which run right away.
+ * 			Saves done are reported as the next command is read.
+ * 			Returns once the input ends and the jobs and saves are done
+ *
+ */
+
+void TableManager::startConsole() {
+	jobs.setBackground(true);
+	Console::out() << "Open a text file (.txt) to read: (open <file>.txt)" << std::endl;
+	std::string userInput;
+
+	while (std::getline(Console::in(), userInput)) {
+		if (saver.hasReports())
+			Console::out() << saver.takeReports() << std::flush;
+
+		if (!isImmediate(userInput) && jobs.isBusy()) {
+			jobs.enqueue(userInput, StringUtils::trim(std::string_view(userInput)) == "batch" ? readConsoleEdits() : "");
+			continue;
+		}
+
+		runCommand(userInput);
+
+		if (!jobs.isBusy())
+			workbook.trim();
+	};
+
+	jobs.wait();
+	saver.wait();
+	Console::out() << saver.takeReports() << std::flush;
+}
+
+/**
+ * @brief				Runs the commands of a script, one per line, without the console.
+ * 						The script is mapped whole and its lines read straight from the
+ * 						mapping, each command is looked up in the command table and run
+ * 						as typed on the console. Messages are buffered and written out in
+ * 						blocks, quiet scripts write out only the messages of failures.
+ * 						Jobs run inline. Saves are reported after the command they finish
+ * 						during, all of them before the script returns. The script ends at
+ * 						its last line or at an exit command
+ *
+ * @param [in]	script	Script file
+ *
+ * @param [in]	quiet	True to write out only failures
+ *
+ * @returns				Exit status: SCRIPT_SUCCEEDED if every command and save succeeded,
+ * 						SCRIPT_FAILED if any failed, SCRIPT_UNREADABLE if the script cannot
+ * 						be read
+ */
+
+int TableManager::runScript(const std::string& script, bool quiet) {
+	const MappedFile data(script);
+
+	if (!data.isOpen()) {
+		Console::error() << "Error opening the script " << script << "!" << std::endl;
+		return SCRIPT_UNREADABLE;
+	}
+
+	ScriptBuffer lines(data.data(), data.size());
+	OutputBuffer messages(std::cout.rdbuf());
+	std::istream input(&lines);
+	std::ostream output(&messages), discarded(nullptr);
+	Console::Binding binding(input, quiet ? discarded : output, &output);
+
+	saver.reportWritten(!quiet);
+	scripted = true;
+
+	for (std::string line; scripted && std::getline(Console::in(), line);) {
+		runCommand(line);
+		workbook.trim();
+
+		if (saver.hasReports())
+			output << saver.takeReports();
+	}
+
+	bool exited = !scripted;
+	scripted = false;
+	saver.wait();
+	output << saver.takeReports();
+
+	if (exited)
+		Console::out() << "Programme terminated succesfully!" << std::endl;
+
+	messages.drain();
+
+	return Console::errors() == 0 && saver.failures() == 0 ? SCRIPT_SUCCEEDED : SCRIPT_FAILED;
+}
+
+/**
+ * @brief				Reads a data file into a new table the way the open command
+ * 						does, without opening it or its journal. Lets the benchmarks
+ * 						time loading
+ *
+ * @param [in]	file	Data file to read
+ *
+ * @param [in]	mode	When the formulas of the table are evaluated
+ *
+ * @returns				Table read, owned by the caller, nullptr if the file cannot be read
+ */
+
+Table* TableManager::readTable(const std::string& file, EvaluationMode mode) {
+	evaluation = mode;
+	Progress progress("open " + file);
+	return readFile(file, progress);
+}
+
+/**
+ * @brief	Reads the edits of a batch typed while a job runs, so the console
+ * 			goes on reading commands after them
+ *
+ * @returns	Lines read, up to and including the line reading "end"
+ */
+
+std::string readConsoleEdits() {
+	std::string input;
+
+	for (std::string line; std::getline(Console::in(), line);) {
+		input.append(line).push_back('\n');
+
+		if (StringUtils::trim(std::string_view(line)) == "end")
+			break;
+	}
+
+	return input;
+}
+
+/**
+ * @brief				Executes a command, timing it. The latency is kept
+ * 						by the name of the command
+ *
+ * @param [in]	command	User command
+ *
+ */
+
+void TableManager::runCommand(std::string& command) {
+	auto start = std::chrono::steady_clock::now();
+	executeCommand(command);
+	auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+	Stats::record(std::string_view(command).substr(0, command.find(' ')), latency.count());
+}
+
+/**
+ * @brief				Checks if a command only reads, so the clients of a server
+ * 						may run it together. Prints and cell values are reads only
+ * 						while the table is settled, otherwise they evaluate formulas
+ * 						or render the frame, which the first of them does alone
+ *
+ * @param [in]	command	User command
+ *
+ * @returns				True if the command changes nothing
+ */
+
+bool TableManager::isReadOnly(std::string_view command) const {
+	command = StringUtils::trim(command);
+
+	if (command == "help" || command == "stats" || command == "sheets")
+		return true;
+
+	if (command != "print" && command.substr(0, 6) != "value ")
+		return false;
+
+	return table == nullptr || table->isSettled();
+}
+
+/**
+ * @brief				Checks if a command is about the commands running in the
+ * 						background, so it runs right away rather than after them
+ *
+ * @param [in]	command	User command
+ *
+ * @returns				True for progress and cancel
+ */
+
+bool TableManager::isImmediate(std::string_view command) const {
+	command = StringUtils::trim(command);
+	return command == "progress" || command == "cancel";
+}
+
+/**
+ * @brief    Prints available user commands
+ *
+ */
+
+void TableManager::help() const {
+	Console::out() << "open <file>                  opens <file>, a .txt table or .etb snapshot\n"
+		<< "close                        closes currently opened file\n"
+		<< "save                         saves the currently open file\n"
+		<< "saveas <file>                saves the currently open file in <file>, .etb for a snapshot\n"
+		<< "compact                      writes the whole table into the open file, emptying its journal\n"
+		<< "help                         prints this information\n"
+		<< "print                        print the current table\n"
+		<< "edit <row> <col> <value>     print the current table\n"
+		<< "value <row> <col>            prints the value of a cell\n"
+		<< "batch [<file>]               applies edits, one per line, from <file> or the console\n"
+		<< "threads <n>                  loads and recalculates on <n> threads\n"
+		<< "evaluation <eager|lazy>      evaluates formulas as cells change, or lazily when first read\n"
+		<< "sheet <name>                 switches to sheet <name>, the file <name>.etb or <name>.txt next to the open file\n"
+		<< "sheets                       lists the sheets loaded or referred to, formulas refer to them as <name>!R<row>C<col>\n"
+		<< "budget <MB>                  evicts the sheets used least recently once sheets take more than <MB>, 0 for no limit\n"
+		<< "stats [reset|on|off]         prints counters and command latencies, clears them or turns them on or off\n"
+		<< "progress                     prints the progress of the open, batch or saves running in the background\n"
+		<< "cancel                       stops the open, batch or saves running in the background, changing nothing\n"
+		<< "exit                         exists the program" << std::endl;
+}
+
+/**
+ * @brief    Exits the programme once every requested save is written. Within
+ * 			 a script, ends the script instead, which waits for the saves
+ *
+ */
+
+void TableManager::exit() {
+	if (scripted) {
+		scripted = false;
+		return;
+	}
+
+	saver.wait();
+	Console::out() << saver.takeReports() << "Programme terminated succesfully!" << std::endl;
+	std::exit(0);
+}
+
+/**
+ * @brief    Closes the current open file and every other sheet, clearing any data read
+ *
+ */
+
+void TableManager::close() {
+	workbook.clear();
+	table = nullptr;
+	journal.detach();
+	Console::out() << "Succesfully closed current file!" << std::endl;
+	file = "";
+}
+
+/**
+ * @brief    Prints the table if present
+ *
+ */
+
+void TableManager::print() const {
+	if (table != nullptr)
+		table->print();
+}
+
+/**
+ * @brief	           Opens a file to read from as the active sheet of a new workbook.
+ * 					   Edits saved to the journal of the file are replayed over the
+ * 					   data read. Sheets the formulas refer to are loaded when needed.
+ * 					   Saves still writing the file are waited for first. Reading
+ * 					   runs as a job, a cancelled open leaves no file open
+ *
+ * @param [in]  file   File to read
+ *
+ */
+
+void TableManager::open(const std::string& file) {
+	if (file.size() < 5) {
+		Console::error() << "Invalid command!" << std::endl;
+		return;
+	}
+
+	if (!validateFile(file))
+		return;
+
+	saver.wait(file);
+	std::fstream myFile(file, std::ios::app);
+
+	if (myFile.is_open()) {
+		Console::out() << "Succesfully opened file " << file << "!" << std::endl;
+		myFile.close();
+
+		std::shared_ptr<Progress> progress = std::make_shared<Progress>("open " + file);
+
+		jobs.run(progress, [this, file, progress] {
+			table = load(file, journal, *progress);
+
+			if (table != nullptr && progress->isCancelled()) {
+				delete table;
+				table = nullptr;
+				journal.detach();
+			}
+
+			if (progress->isCancelled())
+				Console::error() << "Opening the file " << file << " cancelled!" << std::endl;
+
+			if (table == nullptr)
+				return;
+
+			this->file = file;
+			workbook.open(file, table);
+		});
+	}
+
+	else
+		Console::error() << "Error opening the file!" << std::endl;
+
+}
+
+/**
+ * @brief	               Reads a data file or a snapshot and replays the edits
+ * 						   saved to its journal over the data read
+ *
+ * @param [in]  file       File to read
+ *
+ * @param [in]  journal    Journal attached to the file
+ *
+ * @param [in]  progress   Progress of reading, stopped early if cancelled
+ *
+ * @returns			       Table read, nullptr if the file cannot be read
+ * 						   or reading it was cancelled
+ */
+
+Table* TableManager::load(const std::string& file, EditJournal& journal, Progress& progress) {
+	Table* loaded = Snapshot::isSnapshotFile(file) ? readSnapshot(file) : readFile(file, progress);
+
+	if (loaded == nullptr)
+		return nullptr;
+
+	journal.attach(file);
+	std::size_t replayed = journal.replay(*loaded);
+
+	if (replayed != 0)
+		Console::out() << "Replayed " << replayed << " saved edits from the journal" << std::endl;
+
+	return loaded;
+}
+
+/**
+ * @brief	           Reads a sheet of the workbook other than the active one,
+ * 					   along with the edits saved to its journal, once the saves
+ * 					   still writing its file are done
+ *
+ * @param [in]  file   File of the sheet
+ *
+ * @returns			   Table read, nullptr if the file cannot be read
+ */
+
+Table* TableManager::loadSheet(const std::string& file) {
+	saver.wait(file);
+	EditJournal sheetJournal;
+	Progress progress("sheet " + file);
+	return load(file, sheetJournal, progress);
+}
+
+/**
+ * @brief	           Opens a binary snapshot. The table is usable right away, its
+ * 					   cells are read from the mapped file as they are accessed
+ *
+ * @param [in]  file   Snapshot file to open
+ *
+ * @returns			   Table read, nullptr if the file is not a valid snapshot
+ */
+
+Table* TableManager::readSnapshot(const std::string& file) {
+	Table* loaded = Snapshot::open(file);
+
+	if (loaded == nullptr) {
+		if (MappedFile(file).size() != 0) {
+			Console::error() << "Invalid snapshot file!" << std::endl;
+			return nullptr;
+		}
+
+		loaded = new Table(10, 10);
+		Console::out() << "File empty! Generated default 10x10 empty table" << std::endl;
+	}
+
+	loaded->setEvaluationMode(evaluation);
+	return loaded;
+}
+
+/**
+ * @struct	PendingFormula
+ *
+ * @brief	Formula cell found while loading, assigned once all values are in place
+ */
+
+struct PendingFormula
+{
+	int row, col;
+	std::string_view text;
+};
+
+/**
+ * @struct	LoadedChunk
+ *
+ * @brief	Rows of a data file chunk parsed into a table of their own
+ */
+
+struct LoadedChunk
+{
+	Table* table = nullptr;
+	std::size_t usedCells = 0;
+	std::vector<PendingFormula> formulas;
+};
+
+/**
+ * @brief				   Parses a chunk of a data file, made of whole lines, in a single
+ * 						   pass. Cells are assigned straight from slices of the data, growing
+ * 						   the chunk table as rows and columns are encountered. Formulas are
+ * 						   collected with their row numbered from the start of the chunk
+ *
+ * @param [in]	begin	   First byte of the chunk
+ *
+ * @param [in]	end		   Byte past the end of the chunk
+ *
+ * @param [out]	chunk	   Parsed chunk
+ *
+ * @param [in]	progress   Progress of reading the file, parsing stops once
+ * 						   it is cancelled, leaving the chunk incomplete
+ *
+ */
+
+void loadChunk(const char* begin, const char* end, LoadedChunk& chunk, Progress& progress) {
+	const char delimeter = ',';
+	const char* position = begin;
+	const char* reported = begin;
+	int rows = 0, maxColumns = 0, estimatedRows = 0;
+	Table* loaded = new Table(0, 0);
+
+	while (position < end) {
+		if ((std::size_t)(position - reported) >= PROGRESS_STEP) {
+			if (progress.isCancelled())
+				break;
+
+			progress.advance(position - reported);
+			reported = position;
+		}
+
+		const char* lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+
+		if (lineEnd == nullptr)
+			lineEnd = end;
+
+		if (rows == 0)
+			estimatedRows = (end - begin) / (lineEnd - position + 1) + 1;
+
+		++rows;
+		int col = 0;
+
+		for (const char* delim; (delim = static_cast<const char*>(std::memchr(position, delimeter, lineEnd - position))) != nullptr; position = delim + 1) {
+			++col;
+			std::string_view token = StringUtils::trim(std::string_view(position, delim - position));
+
+			if (token.empty())
+				continue;
+
+			++chunk.usedCells;
+
+			if (rows > loaded->getRows() || col > loaded->getColumns()) {
+				int lineColumns = col + std::count(delim + 1, lineEnd, delimeter);
+				int newRows = std::max({ rows, 2 * loaded->getRows(), estimatedRows });
+				int newColumns = loaded->getColumns() >= lineColumns ? loaded->getColumns() : std::max(lineColumns, 2 * loaded->getColumns());
+				std::size_t scanned = (std::size_t)(rows - 1) * newColumns + col;
+
+				loaded->resize(newRows, newColumns, chooseStorageMode(scanned, chunk.usedCells));
+			}
+
+			if (token.front() == '=')
+				chunk.formulas.push_back({ rows, col, token });
+			else
+				loaded->setCell(rows, col, token);
+		}
+
+		maxColumns = std::max(maxColumns, col);
+		position = lineEnd + 1;
+	}
+
+	progress.advance(std::min(position, end) - reported);
+
+	loaded->resize(rows, maxColumns, chooseStorageMode((std::size_t)rows * maxColumns, chunk.usedCells));
+	chunk.table = loaded;
+}
+
+/**
+ * @brief	           Read data from a given file. The file is mapped into memory and split
+ * 					   at line boundaries into one chunk per pool thread, each parsed in a
+ * 					   single pass into rows of its own (see loadChunk). The chunks are then
+ * 					   placed at their row offsets in a table as wide as the widest of them.
+ * 					   If given row has more cells than another one, the second is autofilled
+ * 					   with empty cells. Formulas are compiled once all values are in place
+ * 					   and evaluated together at the end, in dependency order. In lazy mode
+ * 					   they are left pending instead, so opening takes about the parse time.
+ * 					   Progress is counted in bytes parsed. Cancelling stops the parse and
+ * 					   the assignment of formulas, not the final recalculation
+ *
+ * @param [in]  file       File to read
+ *
+ * @param [in]  progress   Progress of reading
+ *
+ * @returns			       Table read, nullptr if the file cannot be read
+ * 						   or reading it was cancelled
+ */
+
+Table* TableManager::readFile(const std::string& file, Progress& progress) {
+	const MappedFile data(file);
+
+	if (!data.isOpen()) {
+		Console::error() << "Error opening the file!" << std::endl;
+		return nullptr;
+	}
+
+	if (data.size() == 0) {
+		Table* loaded = new Table(10, 10);
+		loaded->setEvaluationMode(evaluation);
+		Console::out() << "File empty! Generated default 10x10 empty table" << std::endl;
+		return loaded;
+	}
+
+	progress.expect(data.size());
+
+	const char* end = data.data() + data.size();
+	std::size_t chunkCount = std::min<std::size_t>(ThreadPool::shared().size(), data.size() / MIN_CHUNK_SIZE + 1);
+	std::vector<const char*> bounds = { data.data() };
+
+	for (std::size_t i = 1; i < chunkCount; ++i) {
+		const char* bound = std::max(bounds.back(), data.data() + data.size() / chunkCount * i);
+		const char* lineEnd = static_cast<const char*>(std::memchr(bound, '\n', end - bound));
+		bounds.push_back(lineEnd == nullptr ? end : lineEnd + 1);
+	}
+
+	bounds.push_back(end);
+
+	std::vector<LoadedChunk> chunks(chunkCount);
+
+	ThreadPool::shared().parallelFor(chunkCount, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			loadChunk(bounds[i], bounds[i + 1], chunks[i], progress);
+	});
+
+	if (progress.isCancelled()) {
+		for (LoadedChunk& chunk : chunks)
+			delete chunk.table;
+
+		return nullptr;
+	}
+
+	int rows = 0, columns = 0;
+	std::size_t usedCells = 0;
+
+	for (const LoadedChunk& chunk : chunks) {
+		rows += chunk.table->getRows();
+		columns = std::max(columns, chunk.table->getColumns());
+		usedCells += chunk.usedCells;
+	}
+
+	Table* loaded = chunks[0].table;
+
+	if (chunkCount > 1) {
+		loaded = new Table(rows, columns, chooseStorageMode((std::size_t)rows * columns, usedCells));
+
+		int row = 1;
+
+		for (LoadedChunk& chunk : chunks) {
+			loaded->moveRows(*chunk.table, row);
+			row += chunk.table->getRows();
+		}
+	}
+
+	int offset = 0;
+	std::size_t formulaCount = 0;
+
+	for (const LoadedChunk& chunk : chunks)
+		formulaCount += chunk.formulas.size();
+
+	loaded->reserveFormulas(formulaCount);
+
+	for (LoadedChunk& chunk : chunks) {
+		for (std::size_t i = 0; i < chunk.formulas.size() && !progress.isCancelled(); ++i)
+			loaded->setCell(offset + chunk.formulas[i].row, chunk.formulas[i].col, chunk.formulas[i].text);
+
+		offset += chunk.table->getRows();
+
+		if (chunk.table != loaded)
+			delete chunk.table;
+	}
+
+	if (progress.isCancelled()) {
+		delete loaded;
+		return nullptr;
+	}
+
+	loaded->setEvaluationMode(evaluation);
+	loaded->recalculate();
+	return loaded;
+}
+
+/**
+ * @brief				   Chooses the cell storage layout for a table
+ *
+ * @param  [in]	  size	   Number of table cells
+ *
+ * @param  [in]	  used	   Number of non-empty table cells
+ *
+ * @returns				   Sparse layout if fewer than one in SPARSE_OCCUPANCY
+ * 						   cells are used, dense layout otherwise
+ */
+
+StorageMode chooseStorageMode(std::size_t size, std::size_t used) {
+	return size > used * SPARSE_OCCUPANCY ? StorageMode::Sparse : StorageMode::Dense;
+}
+
+/**
+ * @brief    Saves the current data in the current file. The edits made since the
+ * 			 last save are appended to the journal of the file, which is compacted
+ * 			 into the file once it grows past a fraction of the file size
+ *
+ */
+
+
+void TableManager::save() {
+	assert(!file.empty());
+
+	if (!journal.commit()) {
+		Console::error() << "Error saving the file " << file << "!" << std::endl;
+		return;
+	}
+
+	Console::out() << "Table saved successfully!" << std::endl;
+
+	std::error_code error;
+	std::uintmax_t fileSize = std::filesystem::file_size(file, error);
+
+	if (journal.size() > std::max(MIN_JOURNAL_SIZE, error ? 0 : fileSize / JOURNAL_SIZE_RATIO))
+		compact();
+}
+
+/**
+ * @brief    Saves the current data in the current file, writing the whole table.
+ * 			 A version of the table is saved in the background, the journal of the
+ * 			 file is emptied once the file is written. Snapshots keep formula
+ * 			 results, so pending formulas are evaluated before saving one
+ *
+ */
+
+void TableManager::compact() {
+	if (!journal.commit()) {
+		Console::error() << "Error saving the file " << file << "!" << std::endl;
+		return;
+	}
+
+	if (Snapshot::isSnapshotFile(file))
+		table->evaluate();
+
+	std::uintmax_t journalSize = journal.size();
+
+	saver.save(table->version(), file, [this, file = file, journalSize](bool written) {
+		if (written)
+			journal.reset(file, journalSize);
+	});
+}
+
+/**
+ * @brief			   Writes current data to the file specified. A version of
+ * 					   the table is saved in the background, completion is
+ * 					   reported once the file is written. A journal left next
+ * 					   to another file written is removed along with its edits.
+ * 					   Pending formulas are evaluated before saving a snapshot
+ *
+ * @param [in]  file   File to write data to
+ *
+ */
+
+void TableManager::saveAs(const std::string& file) {
+	if (!validateFile(file))
+		return;
+
+	if (file == this->file) {
+		compact();
+		return;
+	}
+
+	if (Snapshot::isSnapshotFile(file))
+		table->evaluate();
+
+	saver.save(table->version(), file, [file](bool written) {
+		if (written)
+			std::remove(EditJournal::pathOf(file).c_str());
+	});
+}
+
+/**
+ * @brief			Validates if the given file is .txt format and
+ * 					its name is valid
+ *
+ * @param 	file	The file.
+ *
+ * @returns			True if file is valid, false if it fails.
+ */
+
+bool TableManager::validateFile(const std::string& file) {
+	if (file.size() < 5) {
+		Console::error() << "Filename too short! (Hint: File format should be filename.txt)" << std::endl;
+		return false;
+	}
+
+	std::string name = file.substr(0, file.size() - 4);
+	std::string extension = file.substr(file.size() - 4, 4);
+	std::string forbiddenSymbols = "/\?%*:|\"<>.";
+
+	return validateFileExtension(extension) && validateFileName(name);
+}
+
+/**
+ * @brief				Checks if file extension is '.txt' or '.etb'
+ *
+ * @param 	extension	File extension
+ *
+ * @returns				True if it is .txt or .etb, false otherwise
+ *
+ */
+
+bool validateFileExtension(const std::string& extension) {
+	bool result = true;
+
+	if (extension != ".txt" && extension != ".etb") {
+		Console::error() << "Invalid file extension! (Hint: File should be .txt or .etb)" << std::endl;
+		result = false;
+	}
+
+	return result;
+}
+
+/**
+ * @brief			Validates the file name.Name should not contain  any
+ * 					forbidden OS characters specified by the Windows OS
+ *
+ * @param 	name	File name
+ *
+ * @returns			True if it is valid, false otherwise
+ *
+ */
+
+bool validateFileName(const std::string& name) {
+	assert(!name.empty() && "Name should not be empty string");
+
+	bool result = true;
+
+	std::string badChars = "/\?%*:|\"<>.";
+	std::size_t badChar = name.find_first_of(badChars);
+
+	if (badChar != std::string::npos) {
+		Console::error() << "Invalid file name! (Hint: Check forbidden filename characters in Windows OS)" << std::endl;
+		result = false;
+	}
+
+	return result;
+}
+
+/**
+ * @brief	             Edit given cell with the value specified
+ *
+ * @param [in]  args	 User console input specifying the cell and the new value
+ *
+ */
+
+void TableManager::edit(const std::string& args) {
+	CellEdit cellEdit;
+
+	if (parseEdit(args, cellEdit)) {
+		table->editCell(cellEdit.row, cellEdit.col, cellEdit.value);
+
+		if (cellEdit.row >= 1 && cellEdit.row <= table->getRows() && cellEdit.col >= 1 && cellEdit.col <= table->getColumns())
+			journal.record(cellEdit);
+	}
+
+	else
+		Console::error() << "Invalid command! (Hint: Command should be: edit <row> <col> <value>)" << std::endl;
+}
+
+/**
+ * @brief				Splits the arguments of an edit into its cell and value
+ *
+ * @param [in]	args	Edit in the format <row> <col> <value>
+ *
+ * @param [out]	edit	Parsed edit, pointing into the arguments
+ *
+ * @returns				True if the arguments are well formed
+ */
+
+bool parseEdit(std::string_view args, CellEdit& edit) {
+	std::size_t firstDelim = args.find(' ');
+	std::size_t secondDelim = firstDelim == std::string::npos ? firstDelim : args.find(' ', firstDelim + 1);
+
+	if (secondDelim == std::string::npos || secondDelim + 1 >= args.size())
+		return false;
+
+	std::optional<int> row = StringUtils::parseInteger(args.substr(0, firstDelim));
+	std::optional<int> col = StringUtils::parseInteger(args.substr(firstDelim + 1, secondDelim - firstDelim - 1));
+
+	if (!row.has_value() || !col.has_value())
+		return false;
+
+	edit = { row.value(), col.value(), args.substr(secondDelim + 1) };
+	return true;
+}
+
+/**
+ * @brief				Applies a batch of edits, one per line in the format of the edit
+ * 						command, read from a file or, if none is given, from the console
+ * 						until a line reading "end". The edits are applied together with a
+ * 						single recalculation, or not at all if any of them is invalid.
+ * 						A batch read from a file is applied as a job
+ *
+ * @param [in]	file	File to read the edits from, empty to read the console
+ *
+ */
+
+void TableManager::batch(const std::string& file) {
+	if (file.empty()) {
+		Console::out() << "Enter edits as <row> <col> <value>, one per line, and end to apply them" << std::endl;
+
+		std::string input;
+
+		for (std::string line; std::getline(Console::in(), line) && StringUtils::trim(std::string_view(line)) != "end";)
+			input.append(line).push_back('\n');
+
+		Progress progress("batch");
+		applyBatch(input, progress);
+		return;
+	}
+
+	if (!validateFile(file))
+		return;
+
+	std::shared_ptr<Progress> progress = std::make_shared<Progress>("batch " + file);
+
+	jobs.run(progress, [this, file, progress] {
+		const MappedFile mapped(file);
+
+		if (!mapped.isOpen()) {
+			Console::error() << "Error opening the file!" << std::endl;
+			return;
+		}
+
+		applyBatch(std::string_view(mapped.data(), mapped.size()), *progress);
+	});
+}
+
+/**
+ * @brief					Parses a batch of edits and applies them. Progress is counted
+ * 							in bytes parsed, cancelling stops the parse and applies nothing
+ *
+ * @param [in]	text		Edits, one per line
+ *
+ * @param [in]	progress	Progress of the batch
+ *
+ */
+
+void TableManager::applyBatch(std::string_view text, Progress& progress) {
+	std::vector<CellEdit> edits;
+	std::size_t lineNumber = 0, parsed = 0;
+
+	progress.expect(text.size());
+
+	while (!text.empty()) {
+		if (parsed >= PROGRESS_STEP) {
+			if (progress.isCancelled())
+				break;
+
+			progress.advance(parsed);
+			parsed = 0;
+		}
+
+		std::size_t lineEnd = std::min(text.find('\n'), text.size());
+		std::string_view line = StringUtils::trim(text.substr(0, lineEnd));
+		text.remove_prefix(std::min(lineEnd + 1, text.size()));
+		parsed += lineEnd + 1;
+		++lineNumber;
+
+		if (line.empty())
+			continue;
+
+		edits.emplace_back();
+
+		if (!parseEdit(line, edits.back())) {
+			Console::error() << "Invalid edit on line " << lineNumber << "! (Hint: Edits should be: <row> <col> <value>) No edits applied" << std::endl;
+			return;
+		}
+	}
+
+	progress.advance(parsed);
+
+	if (!progress.commit()) {
+		Console::error() << "Batch cancelled! No edits applied" << std::endl;
+		return;
+	}
+
+	std::optional<std::size_t> rejected = table->applyEdits(edits);
+
+	if (rejected.has_value())
+		Console::error() << "Invalid cell or value in edit " << rejected.value() + 1 << "! No edits applied" << std::endl;
+	else {
+		for (const CellEdit& edit : edits)
+			journal.record(edit);
+
+		Console::out() << "Applied " << edits.size() << " edits succesfully!" << std::endl;
+	}
+}
+
+/**
+ * @brief				Sets the number of threads data files are loaded
+ * 						and formulas are recalculated on
+ *
+ * @param [in]  args	User console input after the command name
+ *
+ */
+
+void TableManager::setThreads(const std::string& args) {
+	std::optional<int> count = StringUtils::parseInteger(args);
+
+	if (!count.has_value() || count.value() < 1) {
+		Console::error() << "Invalid command! (Hint: Command should be: threads <n>, n > 0)" << std::endl;
+		return;
+	}
+
+	ThreadPool::shared().resize(count.value());
+	Console::out() << "Data files will be loaded and recalculated on " << count.value() << " thread(s)" << std::endl;
+}
+
+/**
+ * @brief				Sets when formulas of the tables opened, and of the open
+ * 						table, are evaluated
+ *
+ * @param [in]  args	User console input after the command name
+ *
+ */
+
+void TableManager::setEvaluation(const std::string& args) {
+	if (args != "eager" && args != "lazy") {
+		Console::error() << "Invalid command! (Hint: Command should be: evaluation <eager|lazy>)" << std::endl;
+		return;
+	}
+
+	evaluation = args == "lazy" ? EvaluationMode::Lazy : EvaluationMode::Eager;
+
+	if (table != nullptr)
+		table->setEvaluationMode(evaluation);
+
+	if (evaluation == EvaluationMode::Lazy)
+		Console::out() << "Formulas will be evaluated when first read" << std::endl;
+	else
+		Console::out() << "Formulas will be evaluated as cells change" << std::endl;
+}
+
+/**
+ * @brief				Prints the counters and command latencies collected, or clears
+ * 						them, or turns collecting them on or off
+ *
+ * @param [in]  args	User console input after the command name, empty to print
+ *
+ */
+
+void TableManager::stats(const std::string& args) {
+	if (args.empty())
+		Stats::print();
+
+	else if (args == "reset") {
+		Stats::reset();
+		Console::out() << "Statistics cleared!" << std::endl;
+	}
+
+	else if (args == "on" || args == "off") {
+		Stats::enabled = args == "on";
+		Console::out() << "Statistics turned " << args << "!" << std::endl;
+	}
+
+	else
+		Console::error() << "Invalid command! (Hint: Command should be: stats [reset|on|off])" << std::endl;
+}
+
+/**
+ * @brief	Cancels the job running in the background, if any, and the saves
+ * 			being written or waiting. Whatever they were changing is left as
+ * 			it was, each reports being cancelled once it stops
+ *
+ */
+
+void TableManager::cancel() {
+	std::shared_ptr<Progress> job = jobs.current();
+
+	if (job != nullptr && !job->cancel())
+		Console::error() << "Too late to cancel " << job->getTask() << "! (Hint: its changes are being applied)" << std::endl;
+
+	if (!saver.cancel() && job == nullptr)
+		Console::error() << "Nothing to cancel!" << std::endl;
+}
+
+/**
+ * @brief	Prints the progress of the job running in the background
+ * 			and of the save being written, if any
+ *
+ */
+
+void TableManager::progress() const {
+	std::string report;
+
+	for (const std::shared_ptr<Progress>& running : { jobs.current(), saver.current() })
+		if (running != nullptr)
+			report.append(running->describe()).push_back('\n');
+
+	if (report.empty())
+		report = "Nothing running in the background!\n";
+
+	Console::out() << report << std::flush;
+}
+
+/**
+ * @brief				Prints the value of a cell, evaluating it first if needed
+ *
+ * @param [in]  args	User console input specifying the cell as <row> <col>
+ *
+ */
+
+void TableManager::value(const std::string& args) {
+	std::size_t delim = args.find(' ');
+	std::optional<int> row = StringUtils::parseInteger(std::string_view(args).substr(0, delim));
+	std::optional<int> col = delim == std::string::npos ? std::nullopt : StringUtils::parseInteger(std::string_view(args).substr(delim + 1));
+
+	if (!row.has_value() || !col.has_value()) {
+		Console::error() << "Invalid command! (Hint: Command should be: value <row> <col>)" << std::endl;
+		return;
+	}
+
+	std::optional<std::string> cell = table->getValue(row.value(), col.value());
+
+	if (cell.has_value())
+		Console::out() << cell.value() << std::endl;
+	else
+		Console::error() << "Invalid cell!" << std::endl;
+}
+
+/**
+ * @brief				Makes another sheet of the workbook the active one, loading it
+ * 						if needed. Edits of the active sheet should be saved first, as
+ * 						its journal is attached to the new active sheet
+ *
+ * @param [in]  name	Name of the sheet
+ *
+ */
+
+void TableManager::switchSheet(const std::string& name) {
+	if (!StringUtils::isSheetName(name)) {
+		Console::error() << "Invalid command! (Hint: Command should be: sheet <name>, a name of letters, digits and _)" << std::endl;
+		return;
+	}
+
+	if (journal.hasPending()) {
+		Console::error() << "Unsaved edits! (Hint: save before switching sheets)" << std::endl;
+		return;
+	}
+
+	Sheet* sheet = workbook.find(name);
+	Table* loaded = workbook.acquire(*sheet);
+
+	if (loaded == nullptr) {
+		Console::error() << "Sheet not found! (Hint: sheets are the .etb or .txt files next to the open file)" << std::endl;
+		return;
+	}
+
+	workbook.activate(*sheet);
+	table = loaded;
+	file = sheet->file;
+	journal.attach(file);
+	Console::out() << "Switched to sheet " << name << "!" << std::endl;
+}
+
+/**
+ * @brief	Lists the sheets of the workbook
+ *
+ */
+
+void TableManager::sheets() const {
+	workbook.list();
+}
+
+/**
+ * @brief				Sets the memory the loaded sheets may take before those
+ * 						used least recently are evicted
+ *
+ * @param [in]  args	User console input after the command name, in megabytes
+ *
+ */
+
+void TableManager::setBudget(const std::string& args) {
+	std::optional<int> megabytes = StringUtils::parseInteger(args);
+
+	if (!megabytes.has_value() || megabytes.value() < 0) {
+		Console::error() << "Invalid command! (Hint: Command should be: budget <MB>, 0 for no limit)" << std::endl;
+		return;
+	}
+
+	workbook.setBudget((std::size_t)megabytes.value() << 20);
+
+	if (megabytes.value() == 0)
+		Console::out() << "Sheets will never be evicted" << std::endl;
+	else
+		Console::out() << "Sheets will be evicted once they take more than " << megabytes.value() << " MB" << std::endl;
+}
+
+/**
+ * @brief	              Executes a console-typed user command. The command is looked up
+ * 						  by its first word in the command table and run if it takes the
+ * 						  arguments given and is accepted with or without a file open. If
+ * 						  the given input does not match any command, proper error message
+ * 						  is printed
+ *
+ * @param [in]  command	  User console input
+ *
+ */
+
+void TableManager::executeCommand(std::string& command) {
+	StringUtils::trim(command);
+
+	if (command.size() < 4) {
+		Console::error() << "Command too short" << std::endl;
+		return;
+	}
+
+	std::size_t space = command.find(' ');
+	auto entry = commands.find(std::string_view(command).substr(0, space));
+
+	if (entry != commands.end()) {
+		const Command& found = entry->second;
+		bool arguments = found.arguments == Arguments::Optional || (found.arguments == Arguments::Required) == (space != std::string::npos);
+		bool scope = found.scope == Scope::Anywhere || (found.scope == Scope::Open) == !file.empty();
+
+		if (arguments && scope) {
+			found.run(space == std::string::npos ? std::string() : command.substr(space + 1));
+			return;
+		}
+	}
+
+	if (file.empty())
+		Console::error() << "Invalid command!" << std::endl;
+	else
+		Console::error() << "Invalid command! (Hint: type help to see available commands)" << std::endl;
+}
+
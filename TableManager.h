@@ -1,66 +1,176 @@
-#ifndef TABLE_MANAGER_H
-#define TABLE_MANAGER_H
-
-#include "StringUtils.h"
-#include "Table.h"
-#include <iostream>
-#include <string>
-#include <functional>
-#include <map>
-#include <cassert>
-
-/**
- * @class	TableManager
- *
- * @brief	Class responsible for running and managing the table,
- * 			handling user commands and data files
- *
- */
-
-class TableManager
-{
-public:
-	TableManager();
-	~TableManager();
-
-	void startConsole();
-
-private:
-	/**
-	 * Table being currently operated
-	 */
-	Table* table;
-
-	/**
-	 * The file the system is currently working with, if present
-	 */
-	std::string file;
-
-	/**
-	 * Map of user-available plain no-args commands and their string representation
-	 */
-
-	const std::map<std::string, std::function<void(void)>>  functions = {
-		{ "save", std::bind(&TableManager::save, this)},
-		{ "print", std::bind(&TableManager::print, this)},
-		{ "help", std::bind(&TableManager::help, this)},
-		{ "close", std::bind(&TableManager::close, this)},
-		{ "exit", std::bind(&TableManager::exit, this)}
-	};
-
-	void help() const;
-	void exit();
-	void close();
-	void print() const;
-	void open(const std::string&);
-	void readFile(const std::string&);
-	void populateTable(const std::string&, char);
-	void save();
-	void saveAs(const std::string&);
-	bool validateFile(const std::string&);
-	void edit(const std::string&);
-	void executeCommand(std::string&);
-
-};
-
+#ifndef TABLE_MANAGER_H
+#define TABLE_MANAGER_H
+
+#include "StringUtils.h"
+#include "Table.h"
+#include "BackgroundSaver.h"
+#include "EditJournal.h"
+#include "Workbook.h"
+#include "JobRunner.h"
+#include "Progress.h"
+#include <iostream>
+#include <string>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <cassert>
+
+/**
+ * @class	TableManager
+ *
+ * @brief	Class responsible for running and managing the table,
+ * 			handling user commands and data files
+ *
+ */
+
+class TableManager
+{
+	friend class Server;
+
+public:
+	TableManager();
+
+	void startConsole();
+	int runScript(const std::string&, bool);
+	Table* readTable(const std::string&, EvaluationMode);
+
+private:
+	/**
+	 * Table being currently operated, the active sheet of the workbook
+	 */
+	Table* table;
+
+	/**
+	 * The file the system is currently working with, if present
+	 */
+	std::string file;
+
+	/**
+	 * When formulas of the tables opened are evaluated
+	 */
+	EvaluationMode evaluation;
+
+	/**
+	 * Journal of the edits saved since the file was last written whole
+	 */
+	EditJournal journal;
+
+	/**
+	 * Saves copies of the table in the background
+	 */
+	BackgroundSaver saver;
+
+	/**
+	 * Sheets open along with the table, owning every table loaded
+	 */
+	Workbook workbook;
+
+	/**
+	 * Runs long commands of the console in the background, queueing the commands read meanwhile
+	 */
+	JobRunner jobs;
+
+	/**
+	 * True while a script runs, cleared by the exit command to end it
+	 */
+	bool scripted;
+
+	/**
+	 * @enum	Arguments
+	 *
+	 * @brief	Whether a command is followed by arguments, after a space
+	 */
+
+	enum class Arguments
+	{
+		None,
+		Required,
+		Optional
+	};
+
+	/**
+	 * @enum	Scope
+	 *
+	 * @brief	Whether a command runs with a file open, with none open, or either way
+	 */
+
+	enum class Scope
+	{
+		Anywhere,
+		Closed,
+		Open
+	};
+
+	/**
+	 * @struct	Command
+	 *
+	 * @brief	Entry of the command table: the function running a command, given
+	 * 			the arguments after its name, and when the command is accepted
+	 */
+
+	struct Command
+	{
+		std::function<void(const std::string&)> run;
+		Arguments arguments;
+		Scope scope;
+	};
+
+	/**
+	 * Table of the user commands by name, built once, so a command is found by a single lookup of its first word
+	 */
+
+	const std::unordered_map<std::string_view, Command> commands = {
+		{ "stats", { std::bind(&TableManager::stats, this, std::placeholders::_1), Arguments::Optional, Scope::Anywhere } },
+		{ "cancel", { std::bind(&TableManager::cancel, this), Arguments::None, Scope::Anywhere } },
+		{ "progress", { std::bind(&TableManager::progress, this), Arguments::None, Scope::Anywhere } },
+		{ "threads", { std::bind(&TableManager::setThreads, this, std::placeholders::_1), Arguments::Required, Scope::Anywhere } },
+		{ "evaluation", { std::bind(&TableManager::setEvaluation, this, std::placeholders::_1), Arguments::Required, Scope::Anywhere } },
+		{ "budget", { std::bind(&TableManager::setBudget, this, std::placeholders::_1), Arguments::Required, Scope::Anywhere } },
+		{ "open", { std::bind(&TableManager::open, this, std::placeholders::_1), Arguments::Required, Scope::Closed } },
+		{ "save", { std::bind(&TableManager::save, this), Arguments::None, Scope::Open } },
+		{ "compact", { std::bind(&TableManager::compact, this), Arguments::None, Scope::Open } },
+		{ "print", { std::bind(&TableManager::print, this), Arguments::None, Scope::Open } },
+		{ "help", { std::bind(&TableManager::help, this), Arguments::None, Scope::Open } },
+		{ "close", { std::bind(&TableManager::close, this), Arguments::None, Scope::Open } },
+		{ "sheets", { std::bind(&TableManager::sheets, this), Arguments::None, Scope::Open } },
+		{ "exit", { std::bind(&TableManager::exit, this), Arguments::None, Scope::Open } },
+		{ "saveas", { std::bind(&TableManager::saveAs, this, std::placeholders::_1), Arguments::Required, Scope::Open } },
+		{ "batch", { std::bind(&TableManager::batch, this, std::placeholders::_1), Arguments::Optional, Scope::Open } },
+		{ "value", { std::bind(&TableManager::value, this, std::placeholders::_1), Arguments::Required, Scope::Open } },
+		{ "sheet", { std::bind(&TableManager::switchSheet, this, std::placeholders::_1), Arguments::Required, Scope::Open } },
+		{ "edit", { std::bind(&TableManager::edit, this, std::placeholders::_1), Arguments::Required, Scope::Open } }
+	};
+
+	void help() const;
+	void exit();
+	void close();
+	void print() const;
+	void open(const std::string&);
+	Table* load(const std::string&, EditJournal&, Progress&);
+	Table* loadSheet(const std::string&);
+	Table* readFile(const std::string&, Progress&);
+	Table* readSnapshot(const std::string&);
+	void save();
+	void compact();
+	void saveAs(const std::string&);
+	bool validateFile(const std::string&);
+	void edit(const std::string&);
+	void batch(const std::string&);
+	void applyBatch(std::string_view, Progress&);
+	void setThreads(const std::string&);
+	void setEvaluation(const std::string&);
+	void stats(const std::string&);
+	void cancel();
+	void progress() const;
+	void value(const std::string&);
+	void switchSheet(const std::string&);
+	void sheets() const;
+	void setBudget(const std::string&);
+	bool isReadOnly(std::string_view) const;
+	bool isImmediate(std::string_view) const;
+	void runCommand(std::string&);
+	void executeCommand(std::string&);
+
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "TextPool.h"
+#include "StringUtils.h"
+#include <functional>
+
+/**
+ * Size of the hash table of a pool when its first text is interned
+ */
+
+const std::size_t MIN_SLOTS = 16;
+
+/**
+ * @brief	Constructs an empty pool, its reference counts counted
+ *
+ */
+
+TextPool::TextPool() :texts(1), numbers(1, 0.), references(1, 0), indexed(0) {
+}
+
+/**
+ * @brief				Gives the id of a text, adding it to the pool if it is not
+ * 						there yet. The number it represents is parsed only then.
+ * 						The text is counted as held by one more cell
+ *
+ * @param [in]	str		Text, without quotation marks
+ *
+ * @returns				Id of the text
+ */
+
+std::uint32_t TextPool::intern(std::string_view str) {
+	std::size_t slot = find(str);
+	std::uint32_t id = slot == slots.size() ? 0 : slots[slot];
+
+	if (id == 0) {
+		if (freeIds.empty()) {
+			id = texts.size();
+			texts.emplace_back(str);
+			numbers.push_back(0.);
+
+			if (!references.empty())
+				references.push_back(0);
+		}
+
+		else {
+			id = freeIds.back();
+			freeIds.pop_back();
+			texts[id] = str;
+		}
+
+		numbers[id] = StringUtils::parseNumber(str).value_or(0.);
+		index(id);
+	}
+
+	if (!references.empty())
+		++references[id];
+
+	return id;
+}
+
+/**
+ * @brief				Counts a text as held by one cell less, dropping it
+ * 						once no cell holds it. Counts should be counted
+ *
+ * @param [in]	id		Id of the text
+ *
+ */
+
+void TextPool::release(std::uint32_t id) {
+	if (--references[id] != 0)
+		return;
+
+	unindex(id);
+	std::string().swap(texts[id]);
+	numbers[id] = 0.;
+	freeIds.push_back(id);
+}
+
+/**
+ * @brief					Sets the number of cells holding every text, counted
+ * 							by the owner of a pool read without them
+ *
+ * @param [in]	counts		Number of cells holding every id
+ *
+ */
+
+void TextPool::setReferences(std::vector<std::uint32_t>&& counts) {
+	references = std::move(counts);
+}
+
+/**
+ * @brief	Checks if the number of cells holding every text is known
+ *
+ * @returns	True if counted, false for a pool read without them
+ */
+
+bool TextPool::isCounted() const {
+	return !references.empty();
+}
+
+/**
+ * @brief	Gives an estimate of the memory held by the pool in bytes
+ *
+ * @returns	Number of bytes allocated
+ */
+
+std::size_t TextPool::memoryUsage() const {
+	std::size_t bytes = texts.capacity() * sizeof(std::string) + numbers.capacity() * sizeof(double)
+		+ (references.capacity() + freeIds.capacity() + slots.capacity()) * sizeof(std::uint32_t);
+
+	for (const std::string& text : texts)
+		if (text.capacity() >= sizeof(std::string))
+			bytes += text.capacity() + 1;
+
+	return bytes;
+}
+
+/**
+ * @brief	Rebuilds the numbers and the hash table of a pool whose texts were
+ * 			read as they are, its reference counts left to be counted. Texts
+ * 			kept under several ids by older snapshots are found by the first
+ *
+ */
+
+void TextPool::rebuild() {
+	numbers.assign(texts.size(), 0.);
+	references.clear();
+	slots.clear();
+	indexed = 0;
+
+	std::vector<bool> released(texts.size(), false);
+
+	for (std::uint32_t id : freeIds)
+		released[id] = true;
+
+	for (std::uint32_t id = 1; id < texts.size(); ++id) {
+		if (released[id])
+			continue;
+
+		numbers[id] = StringUtils::parseNumber(texts[id]).value_or(0.);
+
+		std::size_t slot = find(texts[id]);
+
+		if (slot == slots.size() || slots[slot] == 0)
+			index(id);
+	}
+}
+
+/**
+ * @brief				Finds the slot of a text in the hash table, probing
+ * 						from its hash until the text or a free slot is found
+ *
+ * @param [in]	str		Text to find
+ *
+ * @returns				Slot holding the text or the free slot ending the probe,
+ * 						the number of slots if the table is not allocated
+ */
+
+std::size_t TextPool::find(std::string_view str) const {
+	if (slots.empty())
+		return 0;
+
+	std::size_t mask = slots.size() - 1;
+	std::size_t slot = std::hash<std::string_view>()(str) & mask;
+
+	while (slots[slot] != 0 && texts[slots[slot]] != str)
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+/**
+ * @brief				Adds the id of a text missing from the hash table,
+ * 						growing the table first if it would be over half full
+ *
+ * @param [in]	id		Id of the text
+ *
+ */
+
+void TextPool::index(std::uint32_t id) {
+	if (2 * (indexed + 1) > slots.size())
+		grow();
+
+	slots[find(texts[id])] = id;
+	++indexed;
+}
+
+/**
+ * @brief				Removes the id of a text from the hash table, if the text
+ * 						is found under it, shifting later ids of the probe back
+ * 						into the free slot so every probe still finds its text
+ *
+ * @param [in]	id		Id of the text
+ *
+ */
+
+void TextPool::unindex(std::uint32_t id) {
+	std::size_t slot = find(texts[id]);
+
+	if (slot == slots.size() || slots[slot] != id)
+		return;
+
+	std::size_t mask = slots.size() - 1;
+	slots[slot] = 0;
+	--indexed;
+
+	for (std::size_t next = (slot + 1) & mask; slots[next] != 0; next = (next + 1) & mask) {
+		std::size_t home = std::hash<std::string_view>()(texts[slots[next]]) & mask;
+
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			slots[slot] = slots[next];
+			slots[next] = 0;
+			slot = next;
+		}
+	}
+}
+
+/**
+ * @brief	Doubles the hash table and places every id again
+ *
+ */
+
+void TextPool::grow() {
+	std::vector<std::uint32_t> old;
+	old.swap(slots);
+	slots.assign(old.empty() ? MIN_SLOTS : 2 * old.size(), 0);
+
+	for (std::uint32_t id : old)
+		if (id != 0)
+			slots[find(texts[id])] = id;
+}
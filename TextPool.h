@@ -0,0 +1,103 @@
+#ifndef TEXT_POOL_H
+#define TEXT_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class	TextPool
+ *
+ * @brief	Interned texts of the text cells of a table. Every distinct text is
+ * 			kept once, without its quotation marks, along with the number it
+ * 			represents, and cells refer to it by id. Texts are found by an open
+ * 			addressing hash table of ids and counted by the cells holding them,
+ * 			so a text is dropped and its id reused once its last cell changes
+ *
+ */
+
+class TextPool
+{
+	friend class Snapshot;
+
+public:
+	TextPool();
+
+	std::uint32_t intern(std::string_view);
+	void release(std::uint32_t);
+	void setReferences(std::vector<std::uint32_t>&&);
+	bool isCounted() const;
+	std::size_t memoryUsage() const;
+
+	/**
+	 * @brief	Text of given id, without quotation marks
+	 */
+
+	const std::string& text(std::uint32_t id) const {
+		return texts[id];
+	}
+
+	/**
+	 * @brief	Number the text of given id represents, 0 if none
+	 */
+
+	double number(std::uint32_t id) const {
+		return numbers[id];
+	}
+
+	/**
+	 * @brief	Number of ids, the reserved id 0 and released ids included
+	 */
+
+	std::size_t size() const {
+		return texts.size();
+	}
+
+private:
+	/**
+	 * @brief	Text of every id, id 0 is reserved and released ids are empty
+	 */
+
+	std::vector<std::string> texts;
+
+	/**
+	 * @brief	Number every text represents, 0 if none
+	 */
+
+	std::vector<double> numbers;
+
+	/**
+	 * @brief	Number of cells holding every text, empty while not counted
+	 */
+
+	std::vector<std::uint32_t> references;
+
+	/**
+	 * @brief	Released ids available for reuse
+	 */
+
+	std::vector<std::uint32_t> freeIds;
+
+	/**
+	 * @brief	Hash table of the ids of the texts, 0 marks a free slot. Its size
+	 * 			is a power of two, kept at least twice the number of texts
+	 */
+
+	std::vector<std::uint32_t> slots;
+
+	/**
+	 * @brief	Number of ids in the hash table
+	 */
+
+	std::size_t indexed;
+
+	void rebuild();
+	std::size_t find(std::string_view) const;
+	void index(std::uint32_t);
+	void unindex(std::uint32_t);
+	void grow();
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+/**
+ * @brief	Gives the process-wide pool, sized to the hardware concurrency
+ * 			until resized
+ *
+ * @returns	Shared pool
+ */
+
+ThreadPool& ThreadPool::shared() {
+	static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+	return pool;
+}
+
+/**
+ * @brief				Creates a pool of given size
+ *
+ * @param [in]	threads	Number of threads running each loop, the caller included
+ *
+ */
+
+ThreadPool::ThreadPool(unsigned threads) :task(nullptr), taskSize(0), blockSize(1), next(0), generation(0), pending(0), stopping(false) {
+	start(threads);
+}
+
+/**
+ * @brief	Destructor stopping and joining the workers
+ *
+ */
+
+ThreadPool::~ThreadPool() {
+	stop();
+}
+
+/**
+ * @brief	Gives the number of threads running each loop
+ *
+ * @returns	Pool size, the calling thread included
+ */
+
+unsigned ThreadPool::size() const {
+	return workers.size() + 1;
+}
+
+/**
+ * @brief				Changes the number of threads. Must not be called while
+ * 						a loop is running
+ *
+ * @param [in]	threads	Number of threads running each loop, the caller included
+ *
+ */
+
+void ThreadPool::resize(unsigned threads) {
+	if (threads == size())
+		return;
+
+	stop();
+	start(threads);
+}
+
+/**
+ * @brief				Runs a loop over given number of iterations on all threads
+ * 						of the pool and returns once every iteration is done. The
+ * 						body is called with disjoint ranges covering all iterations
+ *
+ * @param [in]	count	Number of iterations
+ *
+ * @param [in]	body	Loop body, called with the first and past the last iteration
+ * 						of a range
+ *
+ */
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& body) {
+	if (workers.empty() || count < 2) {
+		body(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		task = &body;
+		taskSize = count;
+		blockSize = std::max<std::size_t>(1, count / (4 * size()));
+		next = 0;
+		pending = workers.size();
+		++generation;
+	}
+
+	wake.notify_all();
+	runBlocks();
+
+	std::unique_lock<std::mutex> guard(lock);
+	done.wait(guard, [this] { return pending == 0; });
+	task = nullptr;
+}
+
+/**
+ * @brief				Spawns the workers
+ *
+ * @param [in]	threads	Pool size, the caller included
+ *
+ */
+
+void ThreadPool::start(unsigned threads) {
+	stopping = false;
+
+	for (unsigned i = 1; i < threads; ++i)
+		workers.emplace_back(&ThreadPool::runWorker, this, generation);
+}
+
+/**
+ * @brief	Makes the workers exit and joins them
+ *
+ */
+
+void ThreadPool::stop() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	workers.clear();
+}
+
+/**
+ * @brief				Main loop of a worker: waits for a loop to start, takes part
+ * 						in it and reports back when no iterations are left
+ *
+ * @param [in]	seen	Number of loops started before the worker was spawned
+ *
+ */
+
+void ThreadPool::runWorker(unsigned seen) {
+	std::unique_lock<std::mutex> guard(lock);
+
+	while (true) {
+		wake.wait(guard, [&] { return stopping || generation != seen; });
+
+		if (stopping)
+			return;
+
+		seen = generation;
+		guard.unlock();
+		runBlocks();
+		guard.lock();
+
+		if (--pending == 0)
+			done.notify_one();
+	}
+}
+
+/**
+ * @brief	Runs blocks of iterations of the running loop until none are left
+ *
+ */
+
+void ThreadPool::runBlocks() {
+	for (std::size_t begin; (begin = next.fetch_add(blockSize)) < taskSize;)
+		(*task)(begin, std::min(begin + blockSize, taskSize));
+}
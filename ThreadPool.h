@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class	ThreadPool
+ *
+ * @brief	Fixed set of worker threads running parallel loops. The calling
+ * 			thread takes part in every loop, so a pool of size one runs all
+ * 			work inline. Workers wait on a condition variable between loops
+ * 			and take blocks of iterations off a shared counter while running
+ *
+ */
+
+class ThreadPool
+{
+public:
+	static ThreadPool& shared();
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned size() const;
+	void resize(unsigned);
+	void parallelFor(std::size_t, const std::function<void(std::size_t, std::size_t)>&);
+
+private:
+	ThreadPool(unsigned);
+
+	/**
+	 * @brief	Worker threads, one less than the pool size
+	 */
+
+	std::vector<std::thread> workers;
+
+	/**
+	 * @brief	Guards the loop description and the counters below
+	 */
+
+	std::mutex lock;
+
+	/**
+	 * @brief	Signalled when a loop starts or the pool stops
+	 */
+
+	std::condition_variable wake;
+
+	/**
+	 * @brief	Signalled when the last worker leaves a loop
+	 */
+
+	std::condition_variable done;
+
+	/**
+	 * @brief	Body of the running loop, called with a range of iterations
+	 */
+
+	const std::function<void(std::size_t, std::size_t)>* task;
+
+	/**
+	 * @brief	Number of iterations of the running loop
+	 */
+
+	std::size_t taskSize;
+
+	/**
+	 * @brief	Number of iterations taken at once
+	 */
+
+	std::size_t blockSize;
+
+	/**
+	 * @brief	First iteration not taken yet
+	 */
+
+	std::atomic<std::size_t> next;
+
+	/**
+	 * @brief	Number of loops started, lets workers tell a new loop apart
+	 */
+
+	unsigned generation;
+
+	/**
+	 * @brief	Number of workers that have not finished the running loop
+	 */
+
+	unsigned pending;
+
+	/**
+	 * @brief	Set to make the workers exit
+	 */
+
+	bool stopping;
+
+	void start(unsigned);
+	void stop();
+	void runWorker(unsigned);
+	void runBlocks();
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "Workbook.h"
+#include "Console.h"
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+/**
+ * Extensions a sheet file is looked up by, in order of preference
+ */
+
+const char* const SHEET_EXTENSIONS[] = { ".etb", ".txt" };
+
+/**
+ * @brief				Constructs a workbook with no sheets and no memory budget
+ *
+ * @param [in]	loader	Reads the table of a sheet from its file
+ *
+ */
+
+Workbook::Workbook(Loader loader) :loader(std::move(loader)), active(nullptr), budget(0), clock(0) {
+}
+
+/**
+ * @brief	Destructor deleting the tables of the loaded sheets
+ *
+ */
+
+Workbook::~Workbook() {
+	clear();
+}
+
+/**
+ * @brief				Starts the workbook over with a table read from a file as its
+ * 						active sheet, named after the file. Other sheets are looked
+ * 						up next to the file
+ *
+ * @param [in]	file	File the table was read from
+ *
+ * @param [in]	table	Table read, owned by the workbook from now on
+ *
+ * @returns				Active sheet
+ */
+
+Sheet* Workbook::open(const std::string& file, Table* table) {
+	clear();
+	directory = std::filesystem::path(file).parent_path().string();
+
+	Sheet* sheet = find(nameOf(file));
+	sheet->file = file;
+	sheet->table = table;
+	sheet->generation = 1;
+	table->setWorkbook(this);
+	activate(*sheet);
+
+	return sheet;
+}
+
+/**
+ * @brief				Gives the handle of a sheet, looking up its file the first time
+ * 						the sheet is named. The sheet is not loaded
+ *
+ * @param [in]	name	Sheet name
+ *
+ * @returns				Handle of the sheet, valid until the workbook is cleared
+ */
+
+Sheet* Workbook::find(const std::string& name) {
+	auto sheet = sheets.find(name);
+
+	if (sheet != sheets.end())
+		return sheet->second.get();
+
+	std::unique_ptr<Sheet> added(new Sheet{ name, locate(name), nullptr, 0, 0, 0, false });
+	return sheets.emplace(name, std::move(added)).first->second.get();
+}
+
+/**
+ * @brief				Gives the table of a sheet brought up to date, loading it first
+ * 						if needed. The file of a sheet found missing or unreadable is
+ * 						looked up again, so a sheet created or fixed since is loaded.
+ * 						A sheet being loaded or brought up to date already, as sheets
+ * 						referring to each other are, is given as it is
+ *
+ * @param [in]	sheet	Sheet to use
+ *
+ * @returns				Table of the sheet, nullptr if it has no file or it cannot be read
+ */
+
+Table* Workbook::acquire(Sheet& sheet) {
+	sheet.lastUsed = ++clock;
+
+	if (sheet.busy)
+		return sheet.table;
+
+	if (sheet.table == nullptr) {
+		if (sheet.file.empty())
+			sheet.file = locate(sheet.name);
+
+		if (sheet.file.empty())
+			return nullptr;
+
+		sheet.busy = true;
+		sheet.table = loader(sheet.file);
+		sheet.busy = false;
+
+		if (sheet.table == nullptr) {
+			sheet.file.clear();
+			return nullptr;
+		}
+
+		sheet.table->setWorkbook(this);
+		++sheet.generation;
+	}
+
+	sheet.busy = true;
+	sheet.table->evaluate();
+	sheet.busy = false;
+
+	if (sheet.memory == 0)
+		sheet.memory = sheet.table->memoryUsage();
+
+	return sheet.table;
+}
+
+/**
+ * @brief				Makes a loaded sheet the active one, never evicted
+ *
+ * @param [in]	sheet	Sheet to activate
+ *
+ */
+
+void Workbook::activate(Sheet& sheet) {
+	active = &sheet;
+	sheet.lastUsed = ++clock;
+}
+
+/**
+ * @brief				Sets the memory the loaded sheets may take and evicts
+ * 						sheets until they fit
+ *
+ * @param [in]	bytes	Memory budget in bytes, 0 for no limit
+ *
+ */
+
+void Workbook::setBudget(std::size_t bytes) {
+	budget = bytes;
+	trim();
+}
+
+/**
+ * @brief	Evicts the sheets used least recently, other than the active one,
+ * 			until the loaded sheets fit in the budget. Sheets in use are never
+ * 			evicted, so this is done between commands only
+ *
+ */
+
+void Workbook::trim() {
+	if (budget == 0)
+		return;
+
+	std::size_t used = 0;
+
+	if (active != nullptr && active->table != nullptr)
+		active->memory = active->table->memoryUsage();
+
+	for (const auto& sheet : sheets)
+		if (sheet.second->table != nullptr)
+			used += sheet.second->memory;
+
+	while (used > budget) {
+		Sheet* oldest = nullptr;
+
+		for (const auto& sheet : sheets) {
+			Sheet* candidate = sheet.second.get();
+
+			if (candidate->table != nullptr && candidate != active && !candidate->busy
+				&& (oldest == nullptr || candidate->lastUsed < oldest->lastUsed))
+				oldest = candidate;
+		}
+
+		if (oldest == nullptr)
+			break;
+
+		used -= oldest->memory;
+		evict(*oldest);
+	}
+}
+
+/**
+ * @brief	Deletes every sheet, the active one included
+ *
+ */
+
+void Workbook::clear() {
+	for (const auto& sheet : sheets)
+		delete sheet.second->table;
+
+	sheets.clear();
+	active = nullptr;
+	directory.clear();
+}
+
+/**
+ * @brief	Prints every sheet looked up so far with its state, the memory its
+ * 			table holds if loaded and its file
+ *
+ */
+
+void Workbook::list() const {
+	std::ostringstream output;
+
+	for (const auto& entry : sheets) {
+		const Sheet& sheet = *entry.second;
+		const char* state = &sheet == active ? "active" : sheet.table != nullptr ? "loaded" : sheet.file.empty() ? "missing" : "unloaded";
+
+		output << std::left << std::setw(20) << sheet.name << std::setw(10) << state << std::right;
+
+		if (sheet.table != nullptr)
+			output << std::fixed << std::setprecision(1) << std::setw(9) << sheet.table->memoryUsage() / 1048576. << " MB  ";
+		else
+			output << std::setw(14) << "";
+
+		output << sheet.file << "\n";
+	}
+
+	if (budget != 0)
+		output << "Memory budget: " << budget / 1048576 << " MB\n";
+
+	Console::out() << output.str();
+	Console::out().flush();
+}
+
+/**
+ * @brief				Gives the name of the sheet kept in a file, the file
+ * 						name without directory and extension
+ *
+ * @param [in]	file	File of the sheet
+ *
+ * @returns				Sheet name
+ */
+
+std::string Workbook::nameOf(const std::string& file) {
+	return std::filesystem::path(file).stem().string();
+}
+
+/**
+ * @brief				Looks up the file of a sheet in the workbook directory,
+ * 						a snapshot preferred over a text file
+ *
+ * @param [in]	name	Sheet name
+ *
+ * @returns				File of the sheet, empty if there is none
+ */
+
+std::string Workbook::locate(const std::string& name) const {
+	std::error_code error;
+
+	for (const char* extension : SHEET_EXTENSIONS) {
+		std::string file = (std::filesystem::path(directory) / (name + extension)).string();
+
+		if (std::filesystem::is_regular_file(file, error))
+			return file;
+	}
+
+	return "";
+}
+
+/**
+ * @brief				Drops the table of a sheet, it is loaded again when next used
+ *
+ * @param [in]	sheet	Sheet to evict
+ *
+ */
+
+void Workbook::evict(Sheet& sheet) {
+	delete sheet.table;
+	sheet.table = nullptr;
+	sheet.memory = 0;
+}
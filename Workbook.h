@@ -0,0 +1,147 @@
+#ifndef WORKBOOK_H
+#define WORKBOOK_H
+
+#include "Table.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @struct	Sheet
+ *
+ * @brief	Named table of a workbook, kept in the .etb or .txt file of that
+ * 			name next to the file opened. Handles to a sheet stay valid as
+ * 			long as the workbook is open, its table is loaded on first use
+ * 			and dropped again when evicted
+ */
+
+struct Sheet
+{
+	/**
+	 * @brief	Name of the sheet, the name of its file without extension
+	 */
+
+	std::string name;
+
+	/**
+	 * @brief	File holding the sheet, empty if none was found
+	 */
+
+	std::string file;
+
+	/**
+	 * @brief	Loaded table, nullptr while not loaded
+	 */
+
+	Table* table;
+
+	/**
+	 * @brief	Number of times the table was loaded, so tables referring to the
+	 * 			sheet can tell a table loaded again from the one they have seen
+	 */
+
+	std::uint64_t generation;
+
+	/**
+	 * @brief	Time of the last use, counted in uses of any sheet
+	 */
+
+	std::uint64_t lastUsed;
+
+	/**
+	 * @brief	Memory held by the table when last measured, in bytes
+	 */
+
+	std::size_t memory;
+
+	/**
+	 * @brief	True while the table is being loaded or brought up to date,
+	 * 			so sheets referring to each other are not loaded twice
+	 */
+
+	bool busy;
+};
+
+/**
+ * @class	Workbook
+ *
+ * @brief	Named tables open together, one of them active. Sheets are found by
+ * 			name next to the file opened and loaded the first time a formula of
+ * 			another sheet refers to them or they are activated. Once the loaded
+ * 			sheets take more memory than the budget, those used least recently
+ * 			are evicted, except the active one, and loaded again when next used
+ *
+ */
+
+class Workbook
+{
+public:
+	/**
+	 * @brief	Reads a table from a file, nullptr if it cannot be read
+	 */
+
+	using Loader = std::function<Table*(const std::string&)>;
+
+	Workbook(Loader);
+	~Workbook();
+
+	Workbook(const Workbook&) = delete;
+	Workbook& operator=(const Workbook&) = delete;
+
+	Sheet* open(const std::string&, Table*);
+	Sheet* find(const std::string&);
+	Table* acquire(Sheet&);
+	void activate(Sheet&);
+	void setBudget(std::size_t);
+	void trim();
+	void clear();
+	void list() const;
+
+	static std::string nameOf(const std::string&);
+
+private:
+	/**
+	 * @brief	Reads the table of a sheet
+	 */
+
+	Loader loader;
+
+	/**
+	 * @brief	Sheets looked up so far, loaded or not, keyed by name
+	 */
+
+	std::map<std::string, std::unique_ptr<Sheet>> sheets;
+
+	/**
+	 * @brief	Active sheet, nullptr while no file is open
+	 */
+
+	Sheet* active;
+
+	/**
+	 * @brief	Directory the files of the sheets are looked up in
+	 */
+
+	std::string directory;
+
+	/**
+	 * @brief	Memory the loaded sheets may take before some are evicted,
+	 * 			in bytes, 0 for no limit
+	 */
+
+	std::size_t budget;
+
+	/**
+	 * @brief	Number of sheet uses so far
+	 */
+
+	std::uint64_t clock;
+
+	std::string locate(const std::string&) const;
+	void evict(Sheet&);
+};
+
+#endif
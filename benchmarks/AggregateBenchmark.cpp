@@ -0,0 +1,60 @@
+#include "../Aggregate.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Times the aggregate kernels over a contiguous run of cells, a quarter of them
+ * text or empty, and checks that every kernel gives the same totals.
+ *
+ * Built by the aggregateBenchmark target of the CMake build in the repository root:
+ *     cmake -S . -B build && cmake --build build --target aggregateBenchmark
+ *
+ * Usage: aggregateBenchmark [<cells> [<repetitions>]]
+ */
+
+int main(int argc, char* argv[]) {
+	std::size_t cells = argc > 1 ? std::stoul(argv[1]) : 1 << 16;
+	int repetitions = argc > 2 ? std::stoi(argv[2]) : 2000;
+
+	std::vector<double> values(cells);
+	std::vector<CellType> types(cells);
+	std::mt19937 random(1);
+
+	for (std::size_t i = 0; i < cells; ++i) {
+		int kind = random() % 8;
+		types[i] = kind == 0 ? CellType::Empty : kind == 1 ? CellType::Text : kind < 6 ? CellType::Number : CellType::Formula;
+		values[i] = types[i] == CellType::Empty ? 0. : (double)(random() % 2000001) / 1000. - 1000.;
+	}
+
+	const char* names[] = { "scalar", "sse2", "avx" };
+	Aggregate::Totals reference;
+	Aggregate::accumulate(values.data(), types.data(), cells, reference, Aggregate::Kernel::Scalar);
+
+	std::cout << cells << " cells, " << repetitions << " repetitions" << std::endl;
+
+	for (Aggregate::Kernel kernel : { Aggregate::Kernel::Scalar, Aggregate::Kernel::Sse2, Aggregate::Kernel::Avx }) {
+		if (!Aggregate::isSupported(kernel))
+			continue;
+
+		Aggregate::Totals totals;
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repetitions; ++i) {
+			totals = Aggregate::Totals();
+			Aggregate::accumulate(values.data(), types.data(), cells, totals, kernel);
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		bool same = totals.count == reference.count && totals.minimum == reference.minimum && totals.maximum == reference.maximum
+			&& std::fabs(totals.sum - reference.sum) <= 1e-9 * cells * 1000.;
+
+		std::cout << names[(int)kernel] << ": " << seconds * 1e9 / ((double)cells * repetitions) << " ns/cell, "
+			<< (double)cells * repetitions / seconds / 1e9 << " Gcells/s" << (same ? "" : " MISMATCH") << std::endl;
+	}
+
+	return 0;
+}
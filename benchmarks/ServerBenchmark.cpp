@@ -0,0 +1,431 @@
+#include "../Console.h"
+#include "../EditJournal.h"
+#include "../Server.h"
+#include "../TableManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Load generator for the server mode: clients connected at once send a mix of
+ * cell reads, prints and edits as fast as they are answered. Reports the total
+ * throughput and the latency percentiles of every kind of request as JSON.
+ *
+ * Built by the serverBenchmark target of the CMake build in the repository root:
+ *     cmake -S . -B build && cmake --build build --target serverBenchmark
+ *
+ * Usage: serverBenchmark [--rows <n>] [--columns <n>] [--clients <n>] [--requests <n>]
+ *                        [--prints <ratio>] [--edits <ratio>] [--seed <n>]
+ *                        [--connect <port|socket>] [--output <file>]
+ *
+ * A synthetic table is served from within the benchmark on a Unix domain socket,
+ * unless --connect names the endpoint of a server already running with a file open.
+ * Requests are sent one at a time per client, each waiting for its response.
+ */
+
+/**
+ * @struct	Options
+ *
+ * @brief	Shape of the table served and of the load
+ */
+
+struct Options
+{
+	int rows = 2000;
+	int columns = 10;
+	int clients = 8;
+	int requests = 2000;
+	double prints = 0.05;
+	double edits = 0.05;
+	unsigned seed = 1;
+	std::string connect;
+	std::string output;
+};
+
+/**
+ * @struct	Latencies
+ *
+ * @brief	Latencies of one kind of request, in seconds
+ */
+
+struct Latencies
+{
+	std::string name;
+	std::vector<double> seconds;
+};
+
+/**
+ * @class	NullBuffer
+ *
+ * @brief	Stream buffer discarding everything written to it
+ */
+
+class NullBuffer : public std::streambuf
+{
+protected:
+	int overflow(int c) override {
+		return c;
+	}
+
+	std::streamsize xsputn(const char*, std::streamsize count) override {
+		return count;
+	}
+};
+
+/**
+ * @class	Client
+ *
+ * @brief	Connection to the server sending one command at a time
+ */
+
+class Client
+{
+public:
+	/**
+	 * @brief					Connects to a server
+	 *
+	 * @param [in]	endpoint	Port number at localhost or path of a Unix domain socket
+	 *
+	 */
+
+	Client(const std::string& endpoint) {
+		bool tcp = !endpoint.empty() && std::all_of(endpoint.begin(), endpoint.end(), ::isdigit);
+		socket = ::socket(tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+
+		if (tcp) {
+			sockaddr_in address = {};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(std::stoi(endpoint));
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+			int noDelay = 1;
+			setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+			connected = ::connect(socket, (sockaddr*)&address, sizeof(address)) == 0;
+		}
+
+		else {
+			sockaddr_un address = {};
+			address.sun_family = AF_UNIX;
+			std::strncpy(address.sun_path, endpoint.c_str(), sizeof(address.sun_path) - 1);
+			connected = ::connect(socket, (sockaddr*)&address, sizeof(address)) == 0;
+		}
+	}
+
+	/**
+	 * @brief	Destructor closing the connection
+	 *
+	 */
+
+	~Client() {
+		::close(socket);
+	}
+
+	/**
+	 * @brief	Checks if the client is connected
+	 *
+	 */
+
+	bool isConnected() const {
+		return connected;
+	}
+
+	/**
+	 * @brief				Sends a command and waits for its response
+	 *
+	 * @param [in]	command	Command, without line end
+	 *
+	 * @param [out]	response	Response, without the byte ending it
+	 *
+	 * @returns				True if the response arrived, false if the connection is lost
+	 */
+
+	bool send(const std::string& command, std::string& response) {
+		std::string line = command + "\n";
+
+		if (::send(socket, line.data(), line.size(), MSG_NOSIGNAL) != (ssize_t)line.size())
+			return false;
+
+		std::size_t end;
+
+		while ((end = received.find('\0')) == std::string::npos) {
+			char buffer[1 << 16];
+			ssize_t count = recv(socket, buffer, sizeof(buffer), 0);
+
+			if (count <= 0)
+				return false;
+
+			received.append(buffer, count);
+		}
+
+		response.assign(received, 0, end);
+		received.erase(0, end + 1);
+		return true;
+	}
+
+private:
+	int socket;
+	bool connected;
+	std::string received;
+};
+
+/**
+ * @brief					Writes a synthetic data file of numbers, with a formula
+ * 							adding two cells of the row above in every fifth cell
+ *
+ * @param [in]	options		Shape of the table
+ *
+ * @param [in]	file		File to write
+ *
+ */
+
+void generateTable(const Options& options, const std::string& file) {
+	std::mt19937 random(options.seed);
+	std::ofstream output(file, std::ios::out | std::ios::trunc | std::ios::binary);
+
+	for (int row = 1; row <= options.rows; ++row) {
+		for (int col = 1; col <= options.columns; ++col) {
+			if (row > 1 && random() % 5 == 0)
+				output << "=R" << row - 1 << "C" << random() % options.columns + 1 << "+R" << row - 1 << "C" << col;
+			else
+				output << random() % 100000 / 100.;
+
+			output << ',';
+		}
+
+		output << '\n';
+	}
+}
+
+/**
+ * @brief					Sends the requests of one client, recording the latency
+ * 							of every request by its kind: value, print or edit
+ *
+ * @param [in]	options		Shape of the load
+ *
+ * @param [in]	endpoint	Endpoint of the server
+ *
+ * @param [in]	index		Index of the client, seeding its requests
+ *
+ * @param [out]	latencies	Latencies of the values, prints and edits
+ *
+ * @returns					True if every request was answered
+ */
+
+bool runClient(const Options& options, const std::string& endpoint, int index, std::vector<Latencies>& latencies) {
+	Client client(endpoint);
+	std::mt19937 random(options.seed * 1000 + index);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+	std::string response;
+
+	if (!client.isConnected())
+		return false;
+
+	for (int i = 0; i < options.requests; ++i) {
+		double kind = uniform(random);
+		std::string cell = std::to_string(random() % options.rows + 1) + " " + std::to_string(random() % options.columns + 1);
+		std::size_t slot = kind < options.edits ? 2 : kind < options.edits + options.prints ? 1 : 0;
+		std::string command = slot == 2 ? "edit " + cell + " " + std::to_string(random() % 1000) : slot == 1 ? "print" : "value " + cell;
+
+		auto start = std::chrono::steady_clock::now();
+
+		if (!client.send(command, response))
+			return false;
+
+		latencies[slot].seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	return true;
+}
+
+/**
+ * @brief					Writes the options, the throughput and the latency
+ * 							percentiles as a JSON object
+ *
+ * @param [in,out]	output		Stream to write to
+ *
+ * @param [in]		options		Shape of the load
+ *
+ * @param [in]		seconds		Time taken by all clients
+ *
+ * @param [in]		latencies	Latencies of every kind of request
+ *
+ */
+
+void writeJson(std::ostream& output, const Options& options, double seconds, const std::vector<Latencies>& latencies) {
+	std::size_t total = 0;
+
+	for (const Latencies& kind : latencies)
+		total += kind.seconds.size();
+
+	output << "{\n"
+		<< "  \"rows\": " << options.rows << ",\n"
+		<< "  \"columns\": " << options.columns << ",\n"
+		<< "  \"clients\": " << options.clients << ",\n"
+		<< "  \"requests\": " << total << ",\n"
+		<< "  \"seconds\": " << seconds << ",\n"
+		<< "  \"requestsPerSecond\": " << total / seconds << ",\n"
+		<< "  \"results\": [\n";
+
+	for (std::size_t i = 0; i < latencies.size(); ++i) {
+		std::vector<double> sorted = latencies[i].seconds;
+		std::sort(sorted.begin(), sorted.end());
+
+		auto percentile = [&](double fraction) {
+			return sorted.empty() ? 0. : sorted[std::min(sorted.size() - 1, (std::size_t)(fraction * sorted.size()))] * 1e6;
+		};
+
+		output << "    { \"name\": \"" << latencies[i].name << "\", \"requests\": " << sorted.size()
+			<< ", \"p50Micros\": " << percentile(0.5)
+			<< ", \"p95Micros\": " << percentile(0.95)
+			<< ", \"p99Micros\": " << percentile(0.99)
+			<< ", \"maxMicros\": " << (sorted.empty() ? 0. : sorted.back() * 1e6) << " }"
+			<< (i + 1 < latencies.size() ? "," : "") << "\n";
+	}
+
+	output << "  ]\n}" << std::endl;
+}
+
+/**
+ * @brief					Reads the options from the command line
+ *
+ * @param [in]	argc		Number of arguments
+ *
+ * @param [in]	argv		Arguments
+ *
+ * @param [out]	options		Options read
+ *
+ * @returns					True if every argument is a known option
+ */
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string name = argv[i];
+
+		if (i + 1 >= argc)
+			return false;
+
+		std::string value = argv[++i];
+
+		if (name == "--rows")
+			options.rows = std::stoi(value);
+		else if (name == "--columns")
+			options.columns = std::stoi(value);
+		else if (name == "--clients")
+			options.clients = std::stoi(value);
+		else if (name == "--requests")
+			options.requests = std::stoi(value);
+		else if (name == "--prints")
+			options.prints = std::stod(value);
+		else if (name == "--edits")
+			options.edits = std::stod(value);
+		else if (name == "--seed")
+			options.seed = std::stoul(value);
+		else if (name == "--connect")
+			options.connect = value;
+		else if (name == "--output")
+			options.output = value;
+		else
+			return false;
+	}
+
+	return options.rows > 0 && options.columns > 0 && options.clients > 0 && options.requests > 0
+		&& options.prints >= 0. && options.edits >= 0. && options.prints + options.edits <= 1.;
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+
+	if (!parseOptions(argc, argv, options)) {
+		std::cerr << "Usage: serverBenchmark [--rows <n>] [--columns <n>] [--clients <n>] [--requests <n>] [--prints <ratio>]"
+			<< " [--edits <ratio>] [--seed <n>] [--connect <port|socket>] [--output <file>]" << std::endl;
+		return 1;
+	}
+
+	std::string file = "serverBenchmark" + std::to_string(options.seed) + ".txt";
+	std::string endpoint = options.connect.empty() ? "serverBenchmark" + std::to_string(options.seed) + ".sock" : options.connect;
+	std::unique_ptr<TableManager> manager;
+	std::unique_ptr<Server> server;
+	std::thread accepting;
+	NullBuffer nullBuffer;
+	std::ostream discard(&nullBuffer);
+
+	if (options.connect.empty()) {
+		generateTable(options, file);
+		manager.reset(new TableManager());
+		server.reset(new Server(*manager));
+
+		Console::Binding quiet(std::cin, discard);
+
+		if (!server->listen(endpoint)) {
+			std::cerr << "Error listening on " << endpoint << "!" << std::endl;
+			return 1;
+		}
+
+		accepting = std::thread(&Server::run, server.get());
+
+		std::string response;
+		Client setup(endpoint);
+
+		if (!setup.isConnected() || !setup.send("open " + file, response) || !setup.send("print", response)) {
+			std::cerr << "Error opening the generated table!" << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<std::vector<Latencies>> latencies(options.clients, { { "value", {} }, { "print", {} }, { "edit", {} } });
+	std::vector<std::thread> clients;
+	std::vector<char> succeeded(options.clients, false);
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < options.clients; ++i)
+		clients.emplace_back([&, i]() { succeeded[i] = runClient(options, endpoint, i, latencies[i]); });
+
+	for (std::thread& client : clients)
+		client.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (server != nullptr) {
+		server->stop();
+		accepting.join();
+		server.reset();
+		manager.reset();
+		std::remove(file.c_str());
+		std::remove(EditJournal::pathOf(file).c_str());
+	}
+
+	if (std::count(succeeded.begin(), succeeded.end(), false) != 0) {
+		std::cerr << "Error: the server dropped a client!" << std::endl;
+		return 1;
+	}
+
+	std::vector<Latencies> merged = { { "value", {} }, { "print", {} }, { "edit", {} } };
+
+	for (const std::vector<Latencies>& client : latencies)
+		for (std::size_t kind = 0; kind < merged.size(); ++kind)
+			merged[kind].seconds.insert(merged[kind].seconds.end(), client[kind].seconds.begin(), client[kind].seconds.end());
+
+	if (options.output.empty())
+		writeJson(std::cout, options, seconds, merged);
+	else {
+		std::ofstream output(options.output);
+		writeJson(output, options, seconds, merged);
+	}
+
+	return 0;
+}
@@ -0,0 +1,404 @@
+#include "../TableManager.h"
+#include "../ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Times loading, editing, evaluating, printing and streaming a synthetic table,
+ * and scanning the values of a cell store of the same shape, half filled with
+ * numbers. Writes the results as JSON, along with the bytes held per cell by
+ * both, so runs can be compared.
+ *
+ * Built by the tableBenchmark target of the CMake build in the repository root:
+ *     cmake -S . -B build && cmake --build build --target tableBenchmark
+ *
+ * Usage: tableBenchmark [--rows <n>] [--columns <n>] [--formulas <ratio>] [--texts <ratio>]
+ *                       [--chains <ratio>] [--edits <n>] [--repetitions <n>] [--threads <n>]
+ *                       [--seed <n>] [--lazy] [--output <file>]
+ *
+ * Formulas refer to cells of the rows above. A --chains fraction of them may refer
+ * to other formulas, the rest only to value cells, so the default table has no
+ * dependency chains and an edit recalculates only the formulas reading the cell.
+ */
+
+/**
+ * @struct	Options
+ *
+ * @brief	Shape of the synthetic table and how it is timed
+ */
+
+struct Options
+{
+	int rows = 100000;
+	int columns = 10;
+	double formulas = 0.2;
+	double texts = 0.1;
+	double chains = 0.;
+	int edits = 1000;
+	int repetitions = 3;
+	int threads = 1;
+	unsigned seed = 1;
+	bool lazy = false;
+	std::string output;
+};
+
+/**
+ * @struct	Timing
+ *
+ * @brief	Times of the repetitions of one operation
+ */
+
+struct Timing
+{
+	std::string name;
+	std::size_t operations = 0;
+	std::vector<double> seconds;
+};
+
+/**
+ * @struct	Footprint
+ *
+ * @brief	Memory held per cell, by the loaded table and by a bare cell store
+ * 			of the same shape half filled with numbers
+ */
+
+struct Footprint
+{
+	double tableBytesPerCell = 0.;
+	double storeBytesPerCell = 0.;
+};
+
+/**
+ * @class	NullBuffer
+ *
+ * @brief	Stream buffer discarding everything written to it
+ */
+
+class NullBuffer : public std::streambuf
+{
+protected:
+	int overflow(int c) override {
+		return c;
+	}
+
+	std::streamsize xsputn(const char*, std::streamsize count) override {
+		return count;
+	}
+};
+
+/**
+ * @brief				Loads a data file the way the open command does
+ *
+ * @param [in]	file	Data file
+ *
+ * @param [in]	lazy	True to leave formulas pending
+ *
+ * @returns				Loaded table, owned by the caller
+ */
+
+Table* load(const std::string& file, bool lazy) {
+	TableManager manager;
+	return manager.readTable(file, lazy ? EvaluationMode::Lazy : EvaluationMode::Eager);
+}
+
+/**
+ * @brief					Writes a synthetic data file. Formulas refer to cells of the
+ * 							rows above, averaging two of them or aggregating a run of a
+ * 							column, so results stay bounded along dependency chains.
+ * 							Formulas not allowed to chain refer to value cells only and
+ * 							aggregate runs of a column below its last formula
+ *
+ * @param [in]	options		Shape of the table
+ *
+ * @param [in]	file		File to write
+ *
+ * @returns					Number of formula cells written
+ */
+
+std::size_t generateTable(const Options& options, const std::string& file) {
+	std::mt19937 random(options.seed);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+	std::ofstream output(file, std::ios::out | std::ios::trunc | std::ios::binary);
+	std::vector<bool> formulaCells((std::size_t)options.rows * options.columns);
+	std::vector<int> lastFormulaRows(options.columns, 0);
+	std::size_t formulas = 0;
+	std::string line;
+
+	auto reference = [&](int row, bool chain) {
+		for (int attempt = 0; attempt < 8; ++attempt) {
+			int above = std::max(1, row - 1 - (int)(random() % 100));
+			int col = random() % options.columns + 1;
+
+			if (chain || !formulaCells[(std::size_t)(above - 1) * options.columns + col - 1])
+				return "R" + std::to_string(above) + "C" + std::to_string(col);
+		}
+
+		return std::to_string(random() % 100);
+	};
+
+	for (int row = 1; row <= options.rows; ++row) {
+		line.clear();
+
+		for (int col = 1; col <= options.columns; ++col) {
+			double kind = uniform(random);
+
+			if (row > 1 && kind < options.formulas) {
+				bool chain = uniform(random) < options.chains;
+				int first = std::max(chain ? 1 : lastFormulaRows[col - 1] + 1, row - 1 - (int)(random() % 100));
+
+				if (random() % 4 != 0 || first > row - 1)
+					line += "=" + reference(row, chain) + "*0.5+" + reference(row, chain) + "*0.5";
+				else {
+					const char* names[] = { "AVG", "MIN", "MAX" };
+					line += std::string("=") + names[random() % 3] + "(R" + std::to_string(first) + "C" + std::to_string(col)
+						+ ":R" + std::to_string(row - 1) + "C" + std::to_string(col) + ")";
+				}
+
+				formulaCells[(std::size_t)(row - 1) * options.columns + col - 1] = true;
+				lastFormulaRows[col - 1] = row;
+				++formulas;
+			}
+
+			else if (kind < options.formulas + options.texts)
+				line += "\"text" + std::to_string(random() % 1000) + "\"";
+			else
+				line += std::to_string(random() % 100000 / 100.);
+
+			line.push_back(',');
+		}
+
+		line.push_back('\n');
+		output.write(line.data(), line.size());
+	}
+
+	return formulas;
+}
+
+/**
+ * @brief					Runs an operation a number of times, timing every run
+ *
+ * @param [in]	timing		Timing to record the runs in
+ *
+ * @param [in]	repetitions	Number of runs
+ *
+ * @param [in]	setup		Called before every run, not timed
+ *
+ * @param [in]	operation	Operation to time
+ *
+ */
+
+void measure(Timing& timing, int repetitions, const std::function<void()>& setup, const std::function<void()>& operation) {
+	for (int i = 0; i < repetitions; ++i) {
+		setup();
+
+		auto start = std::chrono::steady_clock::now();
+		operation();
+		timing.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/**
+ * @brief					Writes the options and timings as a JSON object
+ *
+ * @param [in,out]	output	Stream to write to
+ *
+ * @param [in]		options	Shape of the table
+ *
+ * @param [in]		footprint	Memory held per cell
+ *
+ * @param [in]		timings	Timings of the operations
+ *
+ */
+
+void writeJson(std::ostream& output, const Options& options, const Footprint& footprint, const std::vector<Timing>& timings) {
+	output << "{\n"
+		<< "  \"rows\": " << options.rows << ",\n"
+		<< "  \"columns\": " << options.columns << ",\n"
+		<< "  \"formulas\": " << options.formulas << ",\n"
+		<< "  \"texts\": " << options.texts << ",\n"
+		<< "  \"chains\": " << options.chains << ",\n"
+		<< "  \"threads\": " << options.threads << ",\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"evaluation\": \"" << (options.lazy ? "lazy" : "eager") << "\",\n"
+		<< "  \"tableBytesPerCell\": " << footprint.tableBytesPerCell << ",\n"
+		<< "  \"storeBytesPerCell\": " << footprint.storeBytesPerCell << ",\n"
+		<< "  \"results\": [\n";
+
+	for (std::size_t i = 0; i < timings.size(); ++i) {
+		const Timing& timing = timings[i];
+		std::vector<double> sorted = timing.seconds;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.;
+
+		for (double seconds : sorted)
+			total += seconds;
+
+		output << "    { \"name\": \"" << timing.name << "\", \"operations\": " << timing.operations
+			<< ", \"repetitions\": " << sorted.size()
+			<< ", \"best\": " << sorted.front()
+			<< ", \"median\": " << sorted[sorted.size() / 2]
+			<< ", \"mean\": " << total / sorted.size()
+			<< ", \"operationsPerSecond\": " << timing.operations / sorted.front() << " }"
+			<< (i + 1 < timings.size() ? "," : "") << "\n";
+	}
+
+	output << "  ]\n}" << std::endl;
+}
+
+/**
+ * @brief					Reads the options from the command line
+ *
+ * @param [in]	argc		Number of arguments
+ *
+ * @param [in]	argv		Arguments
+ *
+ * @param [out]	options		Options read
+ *
+ * @returns					True if every argument is a known option
+ */
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string name = argv[i];
+
+		if (name == "--lazy") {
+			options.lazy = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			return false;
+
+		std::string value = argv[++i];
+
+		if (name == "--rows")
+			options.rows = std::stoi(value);
+		else if (name == "--columns")
+			options.columns = std::stoi(value);
+		else if (name == "--formulas")
+			options.formulas = std::stod(value);
+		else if (name == "--texts")
+			options.texts = std::stod(value);
+		else if (name == "--chains")
+			options.chains = std::stod(value);
+		else if (name == "--edits")
+			options.edits = std::stoi(value);
+		else if (name == "--repetitions")
+			options.repetitions = std::stoi(value);
+		else if (name == "--threads")
+			options.threads = std::stoi(value);
+		else if (name == "--seed")
+			options.seed = std::stoul(value);
+		else if (name == "--output")
+			options.output = value;
+		else
+			return false;
+	}
+
+	return options.rows > 0 && options.columns > 0 && options.repetitions > 0 && options.threads > 0 && options.edits >= 0;
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+
+	if (!parseOptions(argc, argv, options)) {
+		std::cerr << "Usage: tableBenchmark [--rows <n>] [--columns <n>] [--formulas <ratio>] [--texts <ratio>] [--chains <ratio>] [--edits <n>]"
+			<< " [--repetitions <n>] [--threads <n>] [--seed <n>] [--lazy] [--output <file>]" << std::endl;
+		return 1;
+	}
+
+	ThreadPool::shared().resize(options.threads);
+
+	std::string file = "tableBenchmark" + std::to_string(options.seed) + ".txt";
+	std::size_t formulas = generateTable(options, file);
+
+	std::vector<Timing> timings(7);
+	Table* table = nullptr;
+	NullBuffer nullBuffer;
+	std::ostream discard(&nullBuffer);
+	std::streambuf* console = std::cout.rdbuf();
+
+	timings[0].name = "load";
+	timings[0].operations = (std::size_t)options.rows * options.columns;
+	measure(timings[0], options.repetitions, [&]() { delete table; table = nullptr; }, [&]() { table = load(file, options.lazy); });
+
+	std::unique_ptr<Table> pending(load(file, true));
+	std::remove(file.c_str());
+
+	if (table == nullptr || pending == nullptr) {
+		std::cerr << "Error loading the generated table!" << std::endl;
+		return 1;
+	}
+
+	std::unique_ptr<Table> original(table);
+	std::unique_ptr<Table> copy;
+	std::mt19937 random(options.seed);
+
+	timings[1].name = "edit";
+	timings[1].operations = options.edits;
+	measure(timings[1], options.repetitions, [&]() { copy.reset(new Table(*original)); }, [&]() {
+		for (int i = 0; i < options.edits; ++i)
+			copy->editCell(random() % options.rows + 1, random() % options.columns + 1, std::to_string(random() % 1000), true);
+	});
+
+	timings[2].name = "evaluate";
+	timings[2].operations = formulas;
+	measure(timings[2], options.repetitions, [&]() { copy.reset(new Table(*pending)); }, [&]() { copy->evaluate(); });
+
+	timings[3].name = "recalculate";
+	timings[3].operations = formulas;
+	measure(timings[3], options.repetitions, [&]() { copy.reset(new Table(*original)); copy->setEvaluationMode(EvaluationMode::Eager); },
+		[&]() { copy->recalculate(); });
+
+	timings[4].name = "print";
+	timings[4].operations = (std::size_t)options.rows * options.columns;
+	measure(timings[4], options.repetitions, [&]() { copy.reset(new Table(*original)); copy->evaluate(); std::cout.rdbuf(&nullBuffer); },
+		[&]() { copy->print(); });
+	std::cout.rdbuf(console);
+
+	timings[5].name = "operator<<";
+	timings[5].operations = (std::size_t)options.rows * options.columns;
+	measure(timings[5], options.repetitions, []() {}, [&]() { discard << *original; });
+
+	std::size_t cells = (std::size_t)options.rows * options.columns;
+	CellStore store(options.rows, options.columns);
+	volatile double checksum = 0.;
+
+	for (std::size_t i = 0; i < cells; ++i)
+		if (random() % 2 == 0)
+			store.setNumber(i, random() % 100000 / 100.);
+
+	timings[6].name = "scan";
+	timings[6].operations = cells;
+	measure(timings[6], options.repetitions, []() {}, [&]() {
+		double sum = 0.;
+
+		for (std::size_t i = 0; i < cells; ++i)
+			sum += store.value(i);
+
+		checksum = sum;
+	});
+
+	Footprint footprint;
+	footprint.tableBytesPerCell = (double)original->memoryUsage() / cells;
+	footprint.storeBytesPerCell = (double)store.memoryUsage() / cells;
+
+	if (options.output.empty())
+		writeJson(std::cout, options, footprint, timings);
+	else {
+		std::ofstream output(options.output);
+		writeJson(output, options, footprint, timings);
+	}
+
+	return 0;
+}
@@ -0,0 +1,227 @@
+#include "../StringUtils.h"
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Times the std::regex checks the cell validators used to make against the
+ * single-pass scanners replacing them, over a mix of numbers, texts, cell
+ * references and formulas, valid and not, and checks that both give the same
+ * verdicts and values. Formulas are of the grammar the regex checks knew, with
+ * no ranges or references to other sheets.
+ *
+ * Built by the validatorBenchmark target of the CMake build in the repository root:
+ *     cmake -S . -B build && cmake --build build --target validatorBenchmark
+ *
+ * Usage: validatorBenchmark [<tokens> [<repetitions>]]
+ */
+
+/**
+ * @brief			 Former number check: builds the regex on every call
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the string represents a number
+ */
+
+bool regexIsNumber(const std::string& str) {
+	const std::regex regexNumber("(\\+|-)?[0-9]+[.]?[0-9]*", std::regex_constants::ECMAScript);
+	return std::regex_match(str, regexNumber);
+}
+
+/**
+ * @brief			 Former cell reference check: builds the regex on every call
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the string represents a reference of type 'R<row>C<col>'
+ */
+
+bool regexIsCellReference(const std::string& str) {
+	const std::regex regexCellReference("R[1-9][0-9]*C[1-9][0-9]*", std::regex_constants::ECMAScript);
+	return std::regex_match(str, regexCellReference);
+}
+
+/**
+ * @brief			 Former formula check, splitting the formula at its operators
+ * 					 into substrings checked with the regex checks
+ *
+ * @param [in]	str	 String to check
+ *
+ * @returns			 True if the string represents a formula
+ */
+
+bool regexIsFormula(const std::string& str) {
+	if (str.size() < 2 || str.front() != '=' || !StringUtils::isDigit(str.back()))
+		return false;
+
+	std::size_t pos = 1;
+
+	for (std::size_t i = 1; i < str.size(); ++i) {
+		char ch = str.at(i);
+
+		if (StringUtils::isMathOperator(ch) || i == str.size() - 1) {
+			std::size_t includeLastSymbol = (i == str.size() - 1) ? 1 : 0;
+			std::string temp = str.substr(pos, i - pos + includeLastSymbol);
+
+			if (temp.empty() || StringUtils::isSign(temp.front()) || !(regexIsNumber(temp) || regexIsCellReference(temp)))
+				return false;
+
+			pos = i + 1;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief			 Former number parse: the regex check, then std::stod
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The number, or empty value if the string does not represent one
+ */
+
+std::optional<double> regexParseNumber(const std::string& str) {
+	if (!regexIsNumber(str))
+		return std::nullopt;
+
+	return std::stod(str);
+}
+
+/**
+ * @brief			 Former cell reference parse: the regex check, then std::stoi
+ * 					 of the row and the column
+ *
+ * @param [in]	str	 String to parse
+ *
+ * @returns			 The row and the column, or empty value if the string does not
+ * 					 represent a reference
+ */
+
+std::optional<std::pair<int, int>> regexParseCellReference(const std::string& str) {
+	if (!regexIsCellReference(str))
+		return std::nullopt;
+
+	std::size_t posColumn = str.find('C');
+	return std::make_pair(std::stoi(str.substr(1, posColumn - 1)), std::stoi(str.substr(posColumn + 1)));
+}
+
+/**
+ * @brief					Generates the tokens to check, a mix of numbers, texts,
+ * 							cell references and formulas, about a fifth of them invalid
+ *
+ * @param [in]	count		Number of tokens
+ *
+ * @returns					Tokens
+ */
+
+std::vector<std::string> generateTokens(std::size_t count) {
+	std::mt19937 random(1);
+	std::vector<std::string> tokens;
+	tokens.reserve(count);
+
+	auto number = [&]() {
+		switch (random() % 4) {
+		case 0:
+			return std::to_string(random() % 100000);
+		case 1:
+			return std::to_string(random() % 1000) + "." + std::to_string(random() % 1000);
+		case 2:
+			return "-" + std::to_string(random() % 1000) + "." + std::to_string(random() % 100);
+		default:
+			return "+" + std::to_string(random() % 1000);
+		}
+	};
+
+	auto reference = [&]() {
+		return "R" + std::to_string(random() % 10000 + 1) + "C" + std::to_string(random() % 100 + 1);
+	};
+
+	const char* invalid[] = { "", "+", "-", ".5", "1.2.3", "--1", "12a", "5.", "R0C1", "R1C0", "RC1", "R1C", "r1c1",
+		"R01C1", "=", "=1+", "=+1", "=R1C1**2", "=R1C1+", "=(1)", "\"\"", "abc" };
+
+	for (std::size_t i = 0; i < count; ++i) {
+		switch (random() % 5) {
+		case 0:
+			tokens.push_back(number());
+			break;
+		case 1:
+			tokens.push_back("\"text" + std::to_string(random() % 1000) + "\"");
+			break;
+		case 2:
+			tokens.push_back(reference());
+			break;
+		case 3:
+			tokens.push_back("=" + reference() + "+" + number().substr(0, 5) + "*" + reference());
+			break;
+		default:
+			tokens.push_back(invalid[random() % (sizeof(invalid) / sizeof(invalid[0]))]);
+			break;
+		}
+	}
+
+	return tokens;
+}
+
+/**
+ * @brief					Runs a check over every token a number of times
+ *
+ * @param [in]	name		Name of the check, as printed
+ *
+ * @param [in]	tokens		Tokens to check
+ *
+ * @param [in]	repetitions	Number of runs
+ *
+ * @param [in]	check		Check to time, given a token and its index
+ *
+ */
+
+template <typename Check>
+void measure(const char* name, const std::vector<std::string>& tokens, int repetitions, Check check) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; ++i)
+		for (std::size_t j = 0; j < tokens.size(); ++j)
+			check(tokens[j], j);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << ": " << seconds * 1e9 / ((double)tokens.size() * repetitions) << " ns/token" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	std::size_t count = argc > 1 ? std::stoul(argv[1]) : 10000;
+	int repetitions = argc > 2 ? std::stoi(argv[2]) : 3;
+	std::vector<std::string> tokens = generateTokens(count);
+
+	std::vector<std::optional<double>> numbers(count), expectedNumbers(count);
+	std::vector<std::optional<std::pair<int, int>>> references(count), expectedReferences(count);
+	std::vector<char> formulas(count), expectedFormulas(count);
+
+	std::cout << count << " tokens, " << repetitions << " repetitions" << std::endl;
+
+	measure("regex number", tokens, repetitions, [&](const std::string& token, std::size_t i) { expectedNumbers[i] = regexParseNumber(token); });
+	measure("parseNumber", tokens, repetitions, [&](const std::string& token, std::size_t i) { numbers[i] = StringUtils::parseNumber(token); });
+	measure("regex cell reference", tokens, repetitions, [&](const std::string& token, std::size_t i) { expectedReferences[i] = regexParseCellReference(token); });
+	measure("parseCellReference", tokens, repetitions, [&](const std::string& token, std::size_t i) { references[i] = StringUtils::parseCellReference(token); });
+	measure("regex formula", tokens, repetitions, [&](const std::string& token, std::size_t i) { expectedFormulas[i] = regexIsFormula(token); });
+	measure("isFormula", tokens, repetitions, [&](const std::string& token, std::size_t i) { formulas[i] = StringUtils::isFormula(token); });
+
+	std::size_t mismatches = 0;
+
+	for (std::size_t i = 0; i < count; ++i) {
+		if (numbers[i] == expectedNumbers[i] && references[i] == expectedReferences[i] && formulas[i] == expectedFormulas[i])
+			continue;
+
+		if (++mismatches <= 10)
+			std::cout << "MISMATCH: " << tokens[i] << std::endl;
+	}
+
+	std::cout << (mismatches == 0 ? "same results" : std::to_string(mismatches) + " mismatches") << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}
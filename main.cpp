@@ -1,12 +1,34 @@
-#include "TableManager.h"
-#include <iostream>
-
-int main()
-{
-	TableManager* cp = new TableManager();
-	cp->startConsole();
-
-}
-
-
-
+#include "TableManager.h"
+#include "Server.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+	TableManager* cp = new TableManager();
+
+	if (argc == 3 && std::string(argv[1]) == "--serve") {
+		Server server(*cp);
+
+		if (!server.listen(argv[2]))
+			return 1;
+
+		server.run();
+		return 0;
+	}
+
+	if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--run") {
+		if (argc == 4 && std::string(argv[3]) != "--quiet") {
+			std::cout << "Invalid option " << argv[3] << "! (Hint: electronicTable --run <script> [--quiet])" << std::endl;
+			return 2;
+		}
+
+		return cp->runScript(argv[2], argc == 4);
+	}
+
+	cp->startConsole();
+
+}
+
+
+